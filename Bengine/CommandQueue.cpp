@@ -0,0 +1,43 @@
+#include "CommandQueue.h"
+
+namespace Bengine {
+
+CommandQueue::CommandQueue()
+{
+    // Empty
+}
+
+
+CommandQueue::~CommandQueue()
+{
+    // Empty
+}
+
+
+void CommandQueue::push(std::function<void()> command)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_commands.push_back(std::move(command));
+}
+
+void CommandQueue::execute()
+{
+    // Run them outside the lock, so commands can queue more commands and pushing never waits on them
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_executing.swap(m_commands);
+    }
+
+    for (auto& command : m_executing) {
+        command();
+    }
+    m_executing.clear();
+}
+
+void CommandQueue::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_commands.clear();
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Bengine {
+
+// Functions queued on one thread to run on another, like input going to the physics thread
+class CommandQueue
+{
+public:
+    CommandQueue();
+    ~CommandQueue();
+
+    void push(std::function<void()> command);
+
+    // Runs everything queued so far, in order. Call on the thread the commands are for.
+    void execute();
+
+    void clear();
+
+private:
+    std::vector<std::function<void()>> m_commands;
+    std::vector<std::function<void()>> m_executing; ///< Commands taken out of the queue by execute()
+    std::mutex m_mutex;
+};
+
+}
@@ -0,0 +1,75 @@
+#include "ContactEventQueue.h"
+
+namespace Bengine {
+
+ContactEventQueue::ContactEventQueue()
+{
+    // Empty
+}
+
+
+ContactEventQueue::~ContactEventQueue()
+{
+    // Empty
+}
+
+
+void ContactEventQueue::BeginContact(b2Contact* contact)
+{
+    addEvent(ContactEventType::BEGIN, contact);
+}
+
+void ContactEventQueue::EndContact(b2Contact* contact)
+{
+    addEvent(ContactEventType::END, contact);
+}
+
+void ContactEventQueue::subscribe(b2Fixture* fixture, ContactCallback callback)
+{
+    m_subscribers[fixture] = callback;
+}
+
+void ContactEventQueue::unsubscribe(b2Fixture* fixture)
+{
+    m_subscribers.erase(fixture);
+}
+
+void ContactEventQueue::dispatch()
+{
+    if (!m_subscribers.empty()) {
+        for (auto& e : m_events) {
+            auto it = m_subscribers.find(e.fixture);
+            if (it != m_subscribers.end()) it->second(e);
+
+            it = m_subscribers.find(e.other);
+            if (it != m_subscribers.end()) {
+                ContactEvent swapped = { e.type, e.other, e.fixture };
+                it->second(swapped);
+            }
+        }
+    }
+    m_events.clear();
+}
+
+void ContactEventQueue::clearEvents()
+{
+    m_events.clear();
+}
+
+void ContactEventQueue::clear()
+{
+    m_events.clear();
+    m_subscribers.clear();
+}
+
+void ContactEventQueue::addEvent(ContactEventType type, b2Contact* contact)
+{
+    b2Fixture* a = contact->GetFixtureA();
+    b2Fixture* b = contact->GetFixtureB();
+    if (a->IsSensor() && b->IsSensor()) return;
+
+    ContactEvent e = { type, a, b };
+    m_events.push_back(e);
+}
+
+}
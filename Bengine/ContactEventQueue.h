@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace Bengine {
+
+enum class ContactEventType { BEGIN, END };
+
+struct ContactEvent {
+    ContactEventType type;
+    b2Fixture* fixture; ///< The subscribed fixture when dispatched
+    b2Fixture* other; ///< May already be destroyed for END events, only compare it
+};
+
+typedef std::function<void(const ContactEvent&)> ContactCallback;
+
+// Contact listener that queues begin and end events during a world step, so they can be
+// handled once the step is over, when it's safe to change the world.
+// Contacts between two sensors aren't queued.
+class ContactEventQueue : public b2ContactListener
+{
+public:
+    ContactEventQueue();
+    ~ContactEventQueue();
+
+    virtual void BeginContact(b2Contact* contact) override;
+    virtual void EndContact(b2Contact* contact) override;
+
+    // Calls callback with every contact event of fixture. One callback per fixture.
+    void subscribe(b2Fixture* fixture, ContactCallback callback);
+    // Call before destroying a subscribed fixture
+    void unsubscribe(b2Fixture* fixture);
+
+    // Sends the queued events to their subscribers and empties the queue. Call after each step.
+    void dispatch();
+
+    // Drops the queued events, for when the world was reset without stepping
+    void clearEvents();
+    // Drops the events and subscribers
+    void clear();
+
+    const std::vector<ContactEvent>& getEvents() const { return m_events; }
+
+private:
+    void addEvent(ContactEventType type, b2Contact* contact);
+
+    std::vector<ContactEvent> m_events; ///< Kept between steps so the memory is reused
+    std::unordered_map<b2Fixture*, ContactCallback> m_subscribers;
+};
+
+}
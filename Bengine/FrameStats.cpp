@@ -0,0 +1,250 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace Bengine {
+
+uint64_t getPercentileRank(double percentile, uint64_t count)
+{
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(percentile * count);
+    return std::min(std::max(rank, (uint64_t)1), count);
+}
+
+
+double getPercentile(const std::vector<double>& sorted, double percentile)
+{
+    if (sorted.empty()) return 0.0;
+    return sorted[(size_t)getPercentileRank(percentile, sorted.size()) - 1];
+}
+
+
+TimeHistogram::TimeHistogram()
+{
+    clear();
+}
+
+
+int TimeHistogram::getBucket(float milliseconds)
+{
+    const uint32_t MAX_TIME = (1u << NUM_RANGES) - 1;
+    float microseconds = milliseconds * 1000.0f;
+    uint32_t time = (microseconds <= 0.0f) ? 0 : (microseconds >= MAX_TIME) ? MAX_TIME : (uint32_t)microseconds;
+
+    // Below SUB_BUCKETS microseconds every microsecond has a bucket
+    if (time < SUB_BUCKETS) return (int)time;
+
+    // Above, each power of two is split into SUB_BUCKETS
+    int range = 5;
+    while ((time >> (range + 1)) != 0) range++;
+    return SUB_BUCKETS * (range - 4) + (int)(time >> (range - 5)) - SUB_BUCKETS;
+}
+
+
+float TimeHistogram::getBucketTime(int bucket)
+{
+    if (bucket < SUB_BUCKETS) return (bucket + 1) * 0.001f;
+
+    int range = bucket / SUB_BUCKETS + 4;
+    uint32_t subBucket = (uint32_t)(bucket % SUB_BUCKETS);
+    uint32_t end = (SUB_BUCKETS + subBucket + 1) << (range - 5);
+    return end * 0.001f;
+}
+
+
+void TimeHistogram::clear()
+{
+    std::fill(m_counts, m_counts + NUM_BUCKETS, 0);
+    m_count = 0;
+}
+
+
+float TimeHistogram::getPercentile(float percentile) const
+{
+    if (m_count == 0) return 0.0f;
+
+    uint64_t rank = getPercentileRank(percentile, m_count);
+    uint64_t count = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        count += m_counts[i];
+        if (count >= rank) return getBucketTime(i);
+    }
+    return getMax();
+}
+
+
+float TimeHistogram::getMax() const
+{
+    for (int i = NUM_BUCKETS - 1; i >= 0; i--) {
+        if (m_counts[i] != 0) return getBucketTime(i);
+    }
+    return 0.0f;
+}
+
+
+TimeSeries::TimeSeries()
+{
+    // Empty
+}
+
+
+void TimeSeries::init(size_t windowSize)
+{
+    m_windowBuckets.assign(std::max(windowSize, (size_t)1), 0);
+    clear();
+}
+
+
+void TimeSeries::add(float milliseconds)
+{
+    int bucket = TimeHistogram::getBucket(milliseconds);
+
+    // Once the window is full the oldest sample makes room
+    if (m_window.getCount() == m_windowBuckets.size()) {
+        m_window.remove(m_windowBuckets[m_nextSample]);
+    }
+    m_window.add(bucket);
+    m_windowBuckets[m_nextSample] = (uint16_t)bucket;
+    m_nextSample = (m_nextSample + 1) % m_windowBuckets.size();
+
+    m_total.add(bucket);
+    m_sum += milliseconds;
+    m_max = std::max(m_max, milliseconds);
+}
+
+
+void TimeSeries::clear()
+{
+    m_window.clear();
+    m_total.clear();
+    m_nextSample = 0;
+    m_sum = 0.0;
+    m_max = 0.0f;
+}
+
+
+FrameStats::FrameStats()
+{
+    init(m_budget);
+}
+
+
+void FrameStats::init(float budget, size_t windowSize /* = 600 */)
+{
+    m_budget = budget;
+    m_frameTimes.init(windowSize);
+    m_updateTimes.init(windowSize);
+    m_drawTimes.init(windowSize);
+    clear();
+}
+
+
+void FrameStats::addFrame(float frameTime, float updateTime, float drawTime)
+{
+    m_frameTimes.add(frameTime);
+    m_updateTimes.add(updateTime);
+    m_drawTimes.add(drawTime);
+
+    if (frameTime > m_budget) {
+        m_numStutters++;
+        m_worstStutter = std::max(m_worstStutter, frameTime);
+    }
+}
+
+
+void FrameStats::clear()
+{
+    m_frameTimes.clear();
+    m_updateTimes.clear();
+    m_drawTimes.clear();
+    m_numStutters = 0;
+    m_worstStutter = 0.0f;
+}
+
+
+bool FrameStats::write(const std::string& filePath) const
+{
+    const std::string CSV = ".csv";
+    if (filePath.size() >= CSV.size() && filePath.compare(filePath.size() - CSV.size(), CSV.size(), CSV) == 0) {
+        return writeCsv(filePath);
+    }
+    return writeJson(filePath);
+}
+
+
+bool FrameStats::writeCsv(const std::string& filePath) const
+{
+    FILE* file = fopen(filePath.c_str(), "w");
+    if (!file) {
+        printf("Failed to write frame stats to %s\n", filePath.c_str());
+        return false;
+    }
+
+    // A row per time and range, with the whole run and the window as ranges
+    fprintf(file, "time,range,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+    const char* names[] = { "frame", "update", "draw" };
+    const TimeSeries* series[] = { &m_frameTimes, &m_updateTimes, &m_drawTimes };
+    for (int i = 0; i < 3; i++) {
+        const TimeSeries& s = *series[i];
+        fprintf(file, "%s,total,%llu,%.4f,%.4f,%.4f,%.4f,%.4f\n", names[i], (unsigned long long)s.getCount(), s.getMean(),
+                s.getPercentile(0.5f), s.getPercentile(0.95f), s.getPercentile(0.99f), s.getMax());
+        fprintf(file, "%s,window,%llu,,%.4f,%.4f,%.4f,%.4f\n", names[i], (unsigned long long)s.getWindowCount(),
+                s.getWindowPercentile(0.5f), s.getWindowPercentile(0.95f), s.getWindowPercentile(0.99f), s.getWindowMax());
+    }
+    fprintf(file, "stutters,total,%llu,,,,,%.4f\n", (unsigned long long)m_numStutters, m_worstStutter);
+
+    // Physics has columns of its own, as a second table
+    if (m_hasPhysicsStats) {
+        const PhysicsStats& p = m_physicsStats;
+        fprintf(file, "\nphysics_budget_ms,physics_ms,physics_last_ms,overruns,quality_changes,velocity_iterations,position_iterations,substeps\n");
+        fprintf(file, "%.4f,%.4f,%.4f,%u,%u,%d,%d,%d\n", p.budget, p.frameTime, p.lastFrameTime, p.numOverruns, p.numQualityChanges,
+                p.quality.velocityIterations, p.quality.positionIterations, p.quality.subSteps);
+    }
+
+    fclose(file);
+    return true;
+}
+
+
+bool FrameStats::writeJson(const std::string& filePath) const
+{
+    FILE* file = fopen(filePath.c_str(), "w");
+    if (!file) {
+        printf("Failed to write frame stats to %s\n", filePath.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"budgetMs\": %.4f,\n", m_budget);
+    fprintf(file, "  \"stutters\": %llu,\n", (unsigned long long)m_numStutters);
+    fprintf(file, "  \"worstStutterMs\": %.4f,\n", m_worstStutter);
+
+    const char* names[] = { "frame", "update", "draw" };
+    const TimeSeries* series[] = { &m_frameTimes, &m_updateTimes, &m_drawTimes };
+    for (int i = 0; i < 3; i++) {
+        const TimeSeries& s = *series[i];
+        fprintf(file, "  \"%s\": {\n", names[i]);
+        fprintf(file, "    \"total\": { \"count\": %llu, \"meanMs\": %.4f, \"p50Ms\": %.4f, \"p95Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f },\n",
+                (unsigned long long)s.getCount(), s.getMean(),
+                s.getPercentile(0.5f), s.getPercentile(0.95f), s.getPercentile(0.99f), s.getMax());
+        fprintf(file, "    \"window\": { \"count\": %llu, \"p50Ms\": %.4f, \"p95Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f }\n",
+                (unsigned long long)s.getWindowCount(),
+                s.getWindowPercentile(0.5f), s.getWindowPercentile(0.95f), s.getWindowPercentile(0.99f), s.getWindowMax());
+        fprintf(file, "  }%s\n", (i < 2 || m_hasPhysicsStats) ? "," : "");
+    }
+    if (m_hasPhysicsStats) {
+        const PhysicsStats& p = m_physicsStats;
+        fprintf(file, "  \"physics\": { \"budgetMs\": %.4f, \"frameMs\": %.4f, \"lastFrameMs\": %.4f, \"overruns\": %u, \"qualityChanges\": %u,\n",
+                p.budget, p.frameTime, p.lastFrameTime, p.numOverruns, p.numQualityChanges);
+        fprintf(file, "    \"velocityIterations\": %d, \"positionIterations\": %d, \"subSteps\": %d }\n",
+                p.quality.velocityIterations, p.quality.positionIterations, p.quality.subSteps);
+    }
+    fprintf(file, "}\n");
+
+    fclose(file);
+    return true;
+}
+
+}
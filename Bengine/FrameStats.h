@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PhysicsQualityController.h"
+
+namespace Bengine {
+
+// Nearest rank of percentile, from 0 to 1, among count values. Starts at 1, 0 if there are no values.
+uint64_t getPercentileRank(double percentile, uint64_t count);
+// Nearest rank percentile of sorted values
+double getPercentile(const std::vector<double>& sorted, double percentile);
+
+// Counts times in buckets about 3% wide at any size, like an HDR histogram, so percentiles of 0.1 ms
+// and of 100 ms are equally precise. Times from 1 microsecond to 16 seconds fit, longer ones count as 16 seconds.
+class TimeHistogram
+{
+public:
+    static const int SUB_BUCKETS = 32; ///< Per power of two microseconds
+    static const int NUM_RANGES = 24;
+    static const int NUM_BUCKETS = SUB_BUCKETS * (NUM_RANGES - 4);
+
+    TimeHistogram();
+
+    static int getBucket(float milliseconds);
+    // Highest time that falls into bucket
+    static float getBucketTime(int bucket);
+
+    void add(int bucket) { m_counts[bucket]++; m_count++; }
+    void remove(int bucket) { m_counts[bucket]--; m_count--; }
+    void clear();
+
+    // Time at percentile, from 0 to 1. Rounded up to the end of its bucket.
+    float getPercentile(float percentile) const;
+    float getMax() const;
+    uint64_t getCount() const { return m_count; }
+
+private:
+    uint64_t m_counts[NUM_BUCKETS];
+    uint64_t m_count = 0;
+};
+
+// One kind of time, over the whole run and over the last windowSize samples
+class TimeSeries
+{
+public:
+    TimeSeries();
+
+    void init(size_t windowSize);
+    void add(float milliseconds);
+    void clear();
+
+    // Percentiles from 0 to 1, of the whole run or the window
+    float getPercentile(float percentile) const { return std::min(m_total.getPercentile(percentile), m_max); }
+    float getWindowPercentile(float percentile) const { return std::min(m_window.getPercentile(percentile), m_max); }
+    float getWindowMax() const { return std::min(m_window.getMax(), m_max); }
+    // Exact, not rounded to a bucket
+    float getMax() const { return m_max; }
+    double getMean() const { return m_total.getCount() ? m_sum / m_total.getCount() : 0.0; }
+    uint64_t getCount() const { return m_total.getCount(); }
+    uint64_t getWindowCount() const { return m_window.getCount(); }
+
+private:
+    TimeHistogram m_window;
+    TimeHistogram m_total;
+    std::vector<uint16_t> m_windowBuckets; ///< Ring of the window's samples, to take them out again
+    size_t m_nextSample = 0;
+    double m_sum = 0.0;
+    float m_max = 0.0f;
+};
+
+// Frame, update and draw times of a run, with p50/p95/p99/max over a sliding window and the whole run.
+// Frames over the budget count as stutters. Written as CSV or JSON, for comparing builds.
+class FrameStats
+{
+public:
+    FrameStats();
+
+    // budget in milliseconds, windowSize in frames
+    void init(float budget, size_t windowSize = 600);
+
+    // Times of one frame in milliseconds
+    void addFrame(float frameTime, float updateTime, float drawTime);
+    void clear();
+
+    // Written along with the times, for screens with a PhysicsQualityController
+    void setPhysicsStats(const PhysicsStats& stats) { m_physicsStats = stats; m_hasPhysicsStats = true; }
+    const PhysicsStats& getPhysicsStats() const { return m_physicsStats; }
+    bool hasPhysicsStats() const { return m_hasPhysicsStats; }
+
+    const TimeSeries& getFrameTimes() const { return m_frameTimes; }
+    const TimeSeries& getUpdateTimes() const { return m_updateTimes; }
+    const TimeSeries& getDrawTimes() const { return m_drawTimes; }
+    uint64_t getNumStutters() const { return m_numStutters; }
+    float getBudget() const { return m_budget; }
+
+    // Picks CSV for paths ending in .csv and JSON for anything else. Returns false if the file can't be written.
+    bool write(const std::string& filePath) const;
+    bool writeCsv(const std::string& filePath) const;
+    bool writeJson(const std::string& filePath) const;
+
+private:
+    TimeSeries m_frameTimes;
+    TimeSeries m_updateTimes;
+    TimeSeries m_drawTimes;
+    float m_budget = 1000.0f / 60.0f;
+    uint64_t m_numStutters = 0;
+    float m_worstStutter = 0.0f;
+    PhysicsStats m_physicsStats;
+    bool m_hasPhysicsStats = false;
+};
+
+}
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <vector>
 #include "IOManager.h"
+#include "Profiler.h"
 
 namespace Bengine {
 
@@ -18,6 +19,8 @@ GLSLProgram::~GLSLProgram()
 
 void GLSLProgram::compileShaders(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
 {
+    BENGINE_PROFILE_ZONE("GLSLProgram::compileShaders");
+
     std::string vertSource;
     std::string fragSource;
 
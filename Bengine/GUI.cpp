@@ -1,4 +1,5 @@
 #include "GUI.h"
+#include "Profiler.h"
 #include <SDL/SDL_timer.h>
 
 namespace Bengine {
@@ -42,6 +43,8 @@ void GUI::destroy()
 
 void GUI::draw()
 {
+    BENGINE_PROFILE_ZONE("GUI::draw");
+
     m_renderer->beginRendering();
     m_context->draw();
     m_renderer->endRendering();
@@ -0,0 +1,158 @@
+#include "GpuTimer.h"
+
+#include <cstdio>
+
+namespace Bengine {
+
+// Mesa's llvmpipe gives the time since boot for the first query of a context
+const GLuint64 MAX_PASS_TIME = 1000000000;
+
+// One track for every timer, they all run on the main thread
+static ProfileTrack* getGpuTrack()
+{
+    static ProfileTrack* track = Profiler::addTrack("GPU");
+    return track;
+}
+
+GpuTimer::GpuTimer()
+{
+    // Empty
+}
+
+
+GpuTimer::~GpuTimer()
+{
+    dispose();
+}
+
+
+bool GpuTimer::init(size_t windowSize /* = 600 */)
+{
+    if (m_isSupported) return true;
+
+    m_windowSize = windowSize;
+    // GLEW may know the version or extension without having loaded the functions, as it does on
+    // core contexts without glewExperimental, so the function has to be there as well
+    bool hasTimerQuery = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) && glGetQueryObjectui64v != nullptr;
+    bool hasExtTimerQuery = GLEW_EXT_timer_query && glGetQueryObjectui64vEXT != nullptr;
+    m_isSupported = hasTimerQuery || hasExtTimerQuery;
+    m_useExt = !hasTimerQuery;
+    if (!m_isSupported) {
+        puts("Timer queries aren't supported, GPU passes won't be timed");
+        return false;
+    }
+
+    // Passes added before init get their queries now
+    for (auto& pass : m_passes) {
+        pass.times.init(m_windowSize);
+        for (auto& query : pass.queries) glGenQueries(1, &query.id);
+    }
+    return true;
+}
+
+
+void GpuTimer::dispose()
+{
+    if (m_activePass != -1) endPass();
+
+    for (auto& pass : m_passes) {
+        for (auto& query : pass.queries) {
+            if (query.id != 0) glDeleteQueries(1, &query.id);
+        }
+    }
+    m_passes.clear();
+    m_numDropped = 0;
+    m_isSupported = false;
+}
+
+
+int GpuTimer::addPass(const char* name)
+{
+    m_passes.emplace_back();
+    Pass& pass = m_passes.back();
+    pass.name = name;
+    pass.times.init(m_windowSize);
+    if (m_isSupported) {
+        for (auto& query : pass.queries) glGenQueries(1, &query.id);
+    }
+    return (int)m_passes.size() - 1;
+}
+
+
+void GpuTimer::beginPass(int pass)
+{
+    if (!m_isSupported) return;
+    if (m_activePass != -1) {
+        printf("GPU pass %s began inside %s, passes can't nest\n", m_passes[pass].name, m_passes[m_activePass].name);
+        return;
+    }
+
+    Pass& p = m_passes[pass];
+    Query& query = p.queries[p.nextQuery];
+    // The GPU is more than NUM_QUERIES passes behind, give up on the oldest result instead of waiting for it
+    if (query.isPending && !readResult(p, query)) {
+        query.isPending = false;
+        m_numDropped++;
+    }
+
+    query.issueTime = Profiler::now();
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+    m_activePass = pass;
+}
+
+
+void GpuTimer::endPass()
+{
+    if (m_activePass == -1) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    Pass& p = m_passes[m_activePass];
+    p.queries[p.nextQuery].isPending = true;
+    p.nextQuery = (p.nextQuery + 1) % NUM_QUERIES;
+    m_activePass = -1;
+}
+
+
+void GpuTimer::update()
+{
+    if (!m_isSupported) return;
+
+    for (auto& pass : m_passes) {
+        // Queries finish in the order they were issued, so stop at the first that isn't done
+        for (int i = 0; i < NUM_QUERIES; i++) {
+            Query& query = pass.queries[(pass.nextQuery + i) % NUM_QUERIES];
+            if (!query.isPending) continue;
+            if (!readResult(pass, query)) break;
+        }
+    }
+}
+
+
+bool GpuTimer::readResult(Pass& pass, Query& query)
+{
+    GLint isAvailable = GL_FALSE;
+    glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (!isAvailable) return false;
+
+    GLuint64 time = 0;
+    if (m_useExt) {
+        glGetQueryObjectui64vEXT(query.id, GL_QUERY_RESULT, &time);
+    }
+    else {
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &time);
+    }
+    query.isPending = false;
+
+    if (time > MAX_PASS_TIME) {
+        m_numDropped++;
+        return true;
+    }
+
+    pass.lastTime = (float)(time * 1e-6);
+    pass.times.add(pass.lastTime);
+    Profiler::addZone(getGpuTrack(), pass.name, query.issueTime, query.issueTime + (long long)time);
+    return true;
+}
+
+}
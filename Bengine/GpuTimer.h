@@ -0,0 +1,84 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include "FrameStats.h"
+#include "Profiler.h"
+
+namespace Bengine {
+
+// Times render passes on the GPU with GL_TIME_ELAPSED queries. Every pass has a ring of queries and a result
+// is only read once the GPU says it's there, so the CPU never waits on the GPU for it.
+// Results go to the profiler's "GPU" track, placed at the time the pass was issued.
+// Without timer queries (GL 3.3, ARB_timer_query or EXT_timer_query) every call does nothing.
+class GpuTimer
+{
+public:
+    static const int NUM_QUERIES = 4; ///< Per pass. A result more frames late than this is dropped.
+
+    GpuTimer();
+    ~GpuTimer();
+
+    // Needs a current GL context. windowSize in results, as in TimeSeries.
+    // Returns false if timer queries aren't supported.
+    bool init(size_t windowSize = 600);
+    // Deletes the queries and forgets the passes
+    void dispose();
+    bool isSupported() const { return m_isSupported; }
+
+    // name has to be a string literal. Returns the pass to begin and end.
+    int addPass(const char* name);
+
+    // Only one query can run at a time, so passes can't nest
+    void beginPass(int pass);
+    void endPass();
+
+    // Reads the results that are ready. Call once a frame.
+    void update();
+
+    int getNumPasses() const { return (int)m_passes.size(); }
+    const char* getPassName(int pass) const { return m_passes[pass].name; }
+    // GPU times of the pass in milliseconds
+    const TimeSeries& getPassTimes(int pass) const { return m_passes[pass].times; }
+    float getLastPassTime(int pass) const { return m_passes[pass].lastTime; }
+    // Results that weren't ready before their query came around again, or were over a second
+    int getNumDropped() const { return m_numDropped; }
+
+private:
+    struct Query {
+        GLuint id = 0;
+        bool isPending = false;
+        long long issueTime = 0; ///< Profiler time of beginPass()
+    };
+
+    struct Pass {
+        const char* name = "";
+        Query queries[NUM_QUERIES];
+        int nextQuery = 0; ///< Oldest query, and the one the next beginPass() uses
+        TimeSeries times;
+        float lastTime = 0.0f;
+    };
+
+    bool readResult(Pass& pass, Query& query);
+
+    std::vector<Pass> m_passes;
+    int m_activePass = -1;
+    int m_numDropped = 0;
+    size_t m_windowSize = 600;
+    bool m_isSupported = false;
+    bool m_useExt = false; ///< Only EXT_timer_query, which names the 64-bit read differently
+};
+
+// Times its scope as a GPU pass
+class GpuPassScope
+{
+public:
+    GpuPassScope(GpuTimer& timer, int pass) : m_timer(timer) { m_timer.beginPass(pass); }
+    ~GpuPassScope() { m_timer.endPass(); }
+
+private:
+    GpuTimer& m_timer;
+};
+
+}
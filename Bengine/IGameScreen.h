@@ -43,6 +43,15 @@ public:
     virtual void update() = 0;
     virtual void draw() = 0;
 
+    // Called zero or more times per frame, after update(), with a constant time step.
+    // Physics goes here so it runs at the same speed whatever the frame rate.
+    virtual void fixedUpdate(float timeStep) {
+        // Empty
+    }
+
+    // Whether fixedUpdate() may run on the physics thread, at the same time as update() and draw()
+    virtual bool supportsPhysicsThread() const { return false; }
+
     int getScreenIndex() const { return m_screenIndex; }
     void setRunning() {
         m_currentState = ScreenState::RUNNING;
@@ -2,8 +2,14 @@
 #include "Timing.h"
 #include "ScreenList.h"
 #include "IGameScreen.h"
+#include "Profiler.h"
 
 namespace Bengine {
+
+static float toMilliseconds(Uint64 ticks)
+{
+    return (float)((double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
 	
 IMainGame::IMainGame()
 {
@@ -25,18 +31,62 @@ void IMainGame::run()
 
     FPSLimiter limiter;
     limiter.setMaxFPS(144.0f);
+    // Frames half a frame late or more show as stutters
+    m_frameStats.init(1000.0f / 144.0f * 1.5f);
 
+    resetFixedSteps();
+
+    Profiler::setThreadName("Main");
+
+    Uint64 frameStart = SDL_GetPerformanceCounter();
     while (m_isRunning) {
+        Profiler::beginFrame();
         limiter.begin();
 
-        update();
+        Uint64 updateStart = SDL_GetPerformanceCounter();
+        {
+            BENGINE_PROFILE_ZONE("IMainGame::update");
+            update();
+        }
         if (!m_isRunning) break;
 
-        draw();
+        Uint64 drawStart = SDL_GetPerformanceCounter();
+        {
+            BENGINE_PROFILE_ZONE("IMainGame::draw");
+            draw();
+        }
+        Uint64 drawEnd = SDL_GetPerformanceCounter();
+
+        {
+            BENGINE_PROFILE_ZONE("FPSLimiter::end");
+            m_fps = limiter.end();
+        }
+        {
+            BENGINE_PROFILE_ZONE("Window::swapBuffer");
+            m_window.swapBuffer();
+        }
+
+        Uint64 frameEnd = SDL_GetPerformanceCounter();
+        m_frameStats.addFrame(toMilliseconds(frameEnd - frameStart), toMilliseconds(drawStart - updateStart), toMilliseconds(drawEnd - drawStart));
+        frameStart = frameEnd;
 
-        m_fps = limiter.end();
-        m_window.swapBuffer();
+        if (inputManager.isKeyPressed(SDLK_F9) && !m_frameStatsPath.empty()) {
+            m_frameStats.write(m_frameStatsPath);
+        }
+        if (inputManager.isKeyPressed(SDLK_F10) && !m_tracePath.empty()) {
+            Profiler::captureFrames(m_traceFrames, m_tracePath);
+        }
     }
+
+    if (!m_frameStatsPath.empty()) m_frameStats.write(m_frameStatsPath);
+    Profiler::finishCapture();
+}
+
+
+void IMainGame::setFixedTimeStep(float timeStep, int maxSubSteps)
+{
+    m_timeStep = timeStep;
+    m_maxSubSteps = maxSubSteps;
 }
 
 
@@ -75,8 +125,7 @@ bool IMainGame::init()
     addScreens();
 
     m_currentScreen = m_screenList->getCurrent();
-    m_currentScreen->setRunning();
-    m_currentScreen->onEntry();
+    startScreen();
 
     return true;
 }
@@ -92,7 +141,7 @@ bool IMainGame::initSystems()
 
 void IMainGame::exitGame()
 {
-    m_currentScreen->onExit();
+    exitScreen();
 
     if (m_screenList) {
         m_screenList->destroy();
@@ -112,26 +161,23 @@ void IMainGame::update()
         switch (m_currentScreen->getState()) {
         case ScreenState::RUNNING:
             m_currentScreen->update();
+            updateFixedSteps();
             break;
         case ScreenState::CHANGE_NEXT:
-            m_currentScreen->onExit();
+            exitScreen();
             m_currentScreen = m_screenList->moveNext();
 
-            if (m_currentScreen != nullptr) {
-                m_currentScreen->setRunning();
-                m_currentScreen->onEntry();
-            }
+            if (m_currentScreen != nullptr) startScreen();
 
+            resetFixedSteps();
             break;
         case ScreenState::CHANGE_PREVIOUS:
-            m_currentScreen->onExit();
+            exitScreen();
             m_currentScreen = m_screenList->movePrevious();
 
-            if (m_currentScreen != nullptr) {
-                m_currentScreen->setRunning();
-                m_currentScreen->onEntry();
-            }
+            if (m_currentScreen != nullptr) startScreen();
 
+            resetFixedSteps();
             break;
         case ScreenState::EXIT_APPLICATION:
             exitGame();
@@ -147,6 +193,64 @@ void IMainGame::update()
 }
 
 
+void IMainGame::updateFixedSteps()
+{
+    // The physics thread keeps its own time
+    if (m_physicsThread.isRunning()) {
+        m_interpolationAlpha = m_physicsThread.getInterpolationAlpha();
+        return;
+    }
+
+    Uint64 counter = SDL_GetPerformanceCounter();
+    m_accumulator += (float)((double)(counter - m_previousCounter) / (double)SDL_GetPerformanceFrequency());
+    m_previousCounter = counter;
+
+    // Drop the time we can't catch up on, otherwise slow steps make even more steps
+    const float MAX_ACCUMULATOR = m_timeStep * m_maxSubSteps;
+    if (m_accumulator > MAX_ACCUMULATOR) m_accumulator = MAX_ACCUMULATOR;
+
+    while (m_accumulator >= m_timeStep) {
+        // The screen may have asked to leave in update()
+        if (m_currentScreen->getState() != ScreenState::RUNNING) break;
+
+        m_currentScreen->fixedUpdate(m_timeStep);
+        m_accumulator -= m_timeStep;
+    }
+
+    m_interpolationAlpha = m_accumulator / m_timeStep;
+    if (m_interpolationAlpha > 1.0f) m_interpolationAlpha = 1.0f;
+}
+
+
+void IMainGame::resetFixedSteps()
+{
+    m_accumulator = 0.0f;
+    m_interpolationAlpha = 1.0f;
+    m_previousCounter = SDL_GetPerformanceCounter();
+}
+
+
+void IMainGame::startScreen()
+{
+    m_currentScreen->setRunning();
+    m_currentScreen->onEntry();
+
+    if (m_physicsThreadEnabled && m_currentScreen->supportsPhysicsThread()) {
+        IGameScreen* screen = m_currentScreen;
+        m_physicsThread.start(m_timeStep, m_maxSubSteps, [screen](float timeStep) {
+            screen->fixedUpdate(timeStep);
+        });
+    }
+}
+
+
+void IMainGame::exitScreen()
+{
+    m_physicsThread.stop();
+    if (m_currentScreen) m_currentScreen->onExit();
+}
+
+
 void IMainGame::draw()
 {
     glViewport(0, 0, m_window.getScreenWidth(), m_window.getScreenHeight());
@@ -4,6 +4,8 @@
 #include "Bengine.h"
 #include "InputManager.h"
 #include "Window.h"
+#include "PhysicsThread.h"
+#include "FrameStats.h"
 
 namespace Bengine {
 
@@ -29,6 +31,32 @@ public:
         return m_fps;
     }
 
+    // Screens' fixedUpdate() runs every timeStep seconds of real time, at most maxSubSteps times per frame.
+    // If a frame takes longer than that the game slows down instead of falling further behind.
+    void setFixedTimeStep(float timeStep, int maxSubSteps);
+    float getTimeStep() const { return m_timeStep; }
+
+    // Runs fixedUpdate() on a thread of its own for screens that support it. Set before run().
+    void setPhysicsThreadEnabled(bool enabled) { m_physicsThreadEnabled = enabled; }
+    bool isPhysicsThreadRunning() const { return m_physicsThread.isRunning(); }
+
+    // Holds off fixedUpdate() while the lock is held, for changing what it touches from the main thread
+    std::unique_lock<std::mutex> lockFixedSteps() { return m_physicsThread.lockSteps(); }
+
+    // How far between the last two fixed steps the current frame is, from 0 to 1.
+    // Draw with previous and current state blended by this to hide the step rate.
+    float getInterpolationAlpha() const { return m_interpolationAlpha; }
+
+    // Frame, update and draw times of the run. With a path set, they're written there on exit and when F9 is pressed,
+    // as CSV for paths ending in .csv and JSON otherwise.
+    const FrameStats& getFrameStats() const { return m_frameStats; }
+    void setFrameStatsPath(const std::string& filePath) { m_frameStatsPath = filePath; }
+    // Latest physics quality and cost, written with the frame stats
+    void setPhysicsStats(const PhysicsStats& stats) { m_frameStats.setPhysicsStats(stats); }
+
+    // With a path set, F10 writes a Chrome trace of the profiler zones of the next numFrames frames there
+    void setTracePath(const std::string& filePath, int numFrames = 120) { m_tracePath = filePath; m_traceFrames = numFrames; }
+
     InputManager inputManager;
 
 protected:
@@ -37,11 +65,31 @@ protected:
     virtual void update();
     virtual void draw();
 
+    void updateFixedSteps();
+    void resetFixedSteps(); ///< Forgets time that has passed, for after loading screens
+    void startScreen(); ///< Enters the current screen and starts its fixed steps
+    void exitScreen(); ///< Stops the current screen's fixed steps and exits it
+
     std::unique_ptr<ScreenList> m_screenList = nullptr;
     IGameScreen* m_currentScreen = nullptr;
     bool m_isRunning = false;
     float m_fps = 0.0f;
 
+    float m_timeStep = 1.0f / 144.0f;
+    int m_maxSubSteps = 8;
+    float m_accumulator = 0.0f;
+    float m_interpolationAlpha = 1.0f;
+    Uint64 m_previousCounter = 0;
+
+    bool m_physicsThreadEnabled = false;
+    PhysicsThread m_physicsThread;
+
+    FrameStats m_frameStats;
+    std::string m_frameStatsPath = "";
+
+    std::string m_tracePath = "";
+    int m_traceFrames = 120;
+
     Window m_window;
 };
 
@@ -1,6 +1,14 @@
 #include "IOManager.h"
+#include "Profiler.h"
 #include <fstream>
 #include <filesystem>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
 
 // Namespace alias
 namespace fs = std::tr2::sys;
@@ -9,6 +17,8 @@ namespace Bengine {
 
 bool IOManager::readFileToBuffer(std::string filePath, std::vector<unsigned char>& buffer)
 {
+	BENGINE_PROFILE_ZONE("IOManager::readFileToBuffer");
+
 	// Load the file
 	std::ifstream file(filePath, std::ios::binary);
 	if (file.fail()) {
@@ -42,6 +52,8 @@ bool IOManager::readFileToBuffer(std::string filePath, std::vector<unsigned char
 
 bool IOManager::readFileToBuffer(std::string filePath, std::string& buffer)
 {
+    BENGINE_PROFILE_ZONE("IOManager::readFileToBuffer");
+
     // Load the file
     std::ifstream file(filePath, std::ios::binary);
     if (file.fail()) {
@@ -99,4 +111,27 @@ bool IOManager::makeDirectory(const char* path)
     return fs::create_directory(fs::path(path));
 }
 
+bool IOManager::replaceFile(const char* fromPath, const char* toPath)
+{
+#ifdef _WIN32
+    // rename() refuses to overwrite on Windows
+    if (!MoveFileExA(fromPath, toPath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        printf("Failed to move %s to %s\n", fromPath, toPath);
+        return false;
+    }
+    return true;
+#else
+    if (std::rename(fromPath, toPath) != 0) {
+        perror(toPath);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool IOManager::removeFile(const char* path)
+{
+    return std::remove(path) == 0;
+}
+
 }
\ No newline at end of file
@@ -19,5 +19,9 @@ namespace Bengine {
         static bool getDirectoryEntries(const char* path, std::vector<DirEntry>& rvEntries);
         // Creates a directory, returns false if couldn't make it
         static bool makeDirectory(const char* path);
+        // Moves fromPath over toPath in one step, so toPath is never left half written
+        static bool replaceFile(const char* fromPath, const char* toPath);
+        // Deletes a file, returns false if it didn't exist
+        static bool removeFile(const char* path);
 	};
 }
\ No newline at end of file
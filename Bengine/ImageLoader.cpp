@@ -2,11 +2,14 @@
 #include "picoPNG.h"
 #include "IOManager.h"
 #include "BengineErrors.h"
+#include "Profiler.h"
 
 namespace Bengine {
 
 	GLTexture ImageLoader::loadPNG(std::string filePath)
 	{
+		BENGINE_PROFILE_ZONE("ImageLoader::loadPNG");
+
 		// Create the texture with all values set to 0
 		GLTexture texture = {};
 
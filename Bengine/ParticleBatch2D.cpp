@@ -1,7 +1,49 @@
 #include "ParticleBatch2D.h"
+#include "ParticleEngine2D.h"
+
+#if !defined(BENGINE_NO_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#define BENGINE_PARTICLES_AVX
+#elif !defined(BENGINE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define BENGINE_PARTICLES_SSE
+#endif
 
 namespace Bengine {
 
+// Moves particles by their velocity and ages them. count must be a multiple of 8.
+static void integrateParticles(float* positionX, float* positionY, const float* velocityX, const float* velocityY,
+                               float* life, size_t count, float deltaTime, float decay)
+{
+#if defined(BENGINE_PARTICLES_AVX)
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 lifeLoss = _mm256_set1_ps(decay);
+    for (size_t i = 0; i < count; i += 8) {
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(positionX + i), _mm256_mul_ps(_mm256_loadu_ps(velocityX + i), dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(positionY + i), _mm256_mul_ps(_mm256_loadu_ps(velocityY + i), dt));
+        _mm256_storeu_ps(positionX + i, x);
+        _mm256_storeu_ps(positionY + i, y);
+        _mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), lifeLoss));
+    }
+#elif defined(BENGINE_PARTICLES_SSE)
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 lifeLoss = _mm_set1_ps(decay);
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 x = _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(_mm_loadu_ps(velocityX + i), dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(_mm_loadu_ps(velocityY + i), dt));
+        _mm_storeu_ps(positionX + i, x);
+        _mm_storeu_ps(positionY + i, y);
+        _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), lifeLoss));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        positionX[i] += velocityX[i] * deltaTime;
+        positionY[i] += velocityY[i] * deltaTime;
+        life[i] -= decay;
+    }
+#endif
+}
+
 ParticleBatch2D::ParticleBatch2D()
 {
     // Empty
@@ -10,7 +52,7 @@ ParticleBatch2D::ParticleBatch2D()
 
 ParticleBatch2D::~ParticleBatch2D()
 {
-	delete[] m_particles;
+    // Empty
 }
 
 
@@ -20,79 +62,184 @@ void ParticleBatch2D::init(int maxParticles,
                            std::function<void(Particle2D&, float)> updateFunc /* = defaultParticleUpdate */)
 {
 	m_maxParticles = maxParticles;
-	m_particles = new Particle2D[maxParticles];
     m_decayRate = decayRate;
     m_texture = texture;
     m_updateFunc = updateFunc;
+
+    // The default update is done by the kernel instead
+    typedef void(*UpdateFunction)(Particle2D&, float);
+    const UpdateFunction* function = updateFunc.target<UpdateFunction>();
+    m_hasCustomUpdate = !(function && *function == defaultParticleUpdate);
+
+    const size_t paddedSize = ((size_t)maxParticles + 7) & ~(size_t)7;
+    m_positionX.assign(paddedSize, 0.0f);
+    m_positionY.assign(paddedSize, 0.0f);
+    m_velocityX.assign(paddedSize, 0.0f);
+    m_velocityY.assign(paddedSize, 0.0f);
+    m_life.assign(paddedSize, 0.0f);
+    m_size.assign(paddedSize, 0.0f);
+    m_colors.assign(paddedSize, ColorRGBA8());
+    m_numParticles = 0;
 }
 
 
 void ParticleBatch2D::update(float deltaTime)
 {
-    for (unsigned i = 0; i < m_maxParticles; i++) {
-        // Check if particle is active
-        if (m_particles[i].life > 0.0f) {
-            m_updateFunc(m_particles[i], deltaTime);
-            m_particles[i].life -= m_decayRate * deltaTime;
-        }
+    updateRange(0, m_numParticles, deltaTime);
+    if (hasCollision()) {
+        findCollisionFixtures(deltaTime);
+        collideRange(0, m_numParticles, deltaTime);
     }
+    removeDeadParticles();
 }
 
 
-void ParticleBatch2D::draw(SpriteBatch* spriteBatch)
+void ParticleBatch2D::setCollision(const b2World* world,
+                                   ParticleCollisionResponse response /* = ParticleCollisionResponse::BOUNCE */,
+                                   float restitution /* = 0.5f */)
+{
+    m_collider.init(world, response, restitution);
+}
+
+
+void ParticleBatch2D::findCollisionFixtures(float deltaTime)
+{
+    m_collider.findFixtures(getArrays(), m_numParticles, deltaTime);
+}
+
+
+void ParticleBatch2D::collideRange(size_t begin, size_t end, float deltaTime)
+{
+    // Same padding as updateRange()
+    const size_t count = (end - begin + 7) & ~(size_t)7;
+    m_collider.collide(getArrays(), begin, begin + count, deltaTime);
+}
+
+
+void ParticleBatch2D::updateRange(size_t begin, size_t end, float deltaTime)
 {
-    const glm::vec4 uvRect(0.0f, 0.0f, 1.0f, 1.0f);
+    if (m_hasCustomUpdate) {
+        updateCustom(begin, end, deltaTime);
+        return;
+    }
 
-    for (unsigned i = 0; i < m_maxParticles; i++) {
-        auto& p = m_particles[i];
+    // Ranges only end off a multiple of 8 after the last live particle, where the kernel
+    // runs over up to 7 unused slots
+    const size_t count = (end - begin + 7) & ~(size_t)7;
+    integrateParticles(m_positionX.data() + begin, m_positionY.data() + begin, m_velocityX.data() + begin, m_velocityY.data() + begin,
+                       m_life.data() + begin, count, deltaTime, m_decayRate * deltaTime);
+}
 
-        // Check if particle is active
-        if (p.life > 0.0f) {
-            glm::vec4 destRect(p.position.x, p.position.y, p.size, p.size);
 
-            spriteBatch->draw(destRect, uvRect, m_texture.id, 0.0f, p.color);
+void ParticleBatch2D::updateCustom(size_t begin, size_t end, float deltaTime)
+{
+    Particle2D particle;
+    for (size_t i = begin; i < end; i++) {
+        particle.position = glm::vec2(m_positionX[i], m_positionY[i]);
+        particle.velocity = glm::vec2(m_velocityX[i], m_velocityY[i]);
+        particle.color = m_colors[i];
+        particle.life = m_life[i];
+        particle.size = m_size[i];
+
+        m_updateFunc(particle, deltaTime);
+
+        m_positionX[i] = particle.position.x;
+        m_positionY[i] = particle.position.y;
+        m_velocityX[i] = particle.velocity.x;
+        m_velocityY[i] = particle.velocity.y;
+        m_colors[i] = particle.color;
+        m_size[i] = particle.size;
+        m_life[i] = particle.life - m_decayRate * deltaTime;
+    }
+}
+
+
+void ParticleBatch2D::removeDeadParticles()
+{
+    size_t i = 0;
+    while (i < m_numParticles) {
+        if (m_life[i] > 0.0f) {
+            i++;
+            continue;
         }
+
+        // Check the moved particle again, it may have died too
+        size_t last = --m_numParticles;
+        m_positionX[i] = m_positionX[last];
+        m_positionY[i] = m_positionY[last];
+        m_velocityX[i] = m_velocityX[last];
+        m_velocityY[i] = m_velocityY[last];
+        m_life[i] = m_life[last];
+        m_size[i] = m_size[last];
+        m_colors[i] = m_colors[last];
+    }
+}
+
+
+void ParticleBatch2D::draw(SpriteBatch* spriteBatch)
+{
+    if (m_numParticles == 0) return;
+
+    // Written straight into the vertex stream, particles never need sorting
+    Vertex* vertices = spriteBatch->addQuads(m_texture.id, m_numParticles);
+
+    for (size_t i = 0; i < m_numParticles; i++, vertices += 6) {
+        float x = m_positionX[i];
+        float y = m_positionY[i];
+        float s = m_size[i];
+
+        // Same corners and order as a glyph
+        vertices[0].setPosition(x, y + s);
+        vertices[0].setUV(0.0f, 1.0f);
+        vertices[1].setPosition(x, y);
+        vertices[1].setUV(0.0f, 0.0f);
+        vertices[2].setPosition(x + s, y);
+        vertices[2].setUV(1.0f, 0.0f);
+        vertices[4].setPosition(x + s, y + s);
+        vertices[4].setUV(1.0f, 1.0f);
+        vertices[3] = vertices[2];
+        vertices[5] = vertices[0];
+
+        for (int v = 0; v < 6; v++) vertices[v].color = m_colors[i];
     }
 }
 
 
-void ParticleBatch2D::addParticle(const glm::vec2& position,
+bool ParticleBatch2D::addParticle(const glm::vec2& position,
 								  const glm::vec2& velocity,
 								  const ColorRGBA8& color,
                                   float size)
 {
-    // Find a free particle
-    int particleIndex = findFreeParticle();
+    if (m_numParticles == (size_t)m_maxParticles) return false;
+    if (m_engine && !m_engine->trySpawn(m_priority, m_spawnCredit)) return false;
 
-    auto& p = m_particles[particleIndex];
+    // The first free particle is right after the live ones
+    size_t i = m_numParticles++;
 
     // Initialize the new particle
-    p.life = 1.0f;
-    p.position = position;
-    p.velocity = velocity;
-    p.color = color;
-    p.size = size;
+    m_life[i] = 1.0f;
+    m_positionX[i] = position.x;
+    m_positionY[i] = position.y;
+    m_velocityX[i] = velocity.x;
+    m_velocityY[i] = velocity.y;
+    m_colors[i] = color;
+    m_size[i] = size;
+
+    return true;
 }
 
 
-int ParticleBatch2D::findFreeParticle()
+ParticleArrays ParticleBatch2D::getArrays()
 {
-    for (unsigned i = m_lastFreeParticle; i < m_maxParticles; i++) {
-        if (m_particles[i].life <= 0.0f) {
-            m_lastFreeParticle = i;
-            return i;
-        }
-    }
-
-    for (unsigned i = 0; i < m_lastFreeParticle; i++) {
-        if (m_particles[i].life <= 0.0f) {
-            m_lastFreeParticle = i;
-            return i;
-        }
-    }
-
-    // If no particles are free
-    return 0;
+    ParticleArrays arrays;
+    arrays.positionX = m_positionX.data();
+    arrays.positionY = m_positionY.data();
+    arrays.velocityX = m_velocityX.data();
+    arrays.velocityY = m_velocityY.data();
+    arrays.life = m_life.data();
+    arrays.size = m_size.data();
+    arrays.colors = m_colors.data();
+    return arrays;
 }
 
 }
\ No newline at end of file
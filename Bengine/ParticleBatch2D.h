@@ -3,13 +3,20 @@
 #include <iostream>
 #include <glm/glm.hpp>
 #include <functional>
+#include <vector>
 
 #include "Vertex.h"
 #include "SpriteBatch.h"
 #include "GLTexture.h"
+#include "ParticleCollider2D.h"
 
 namespace Bengine {
 
+class ParticleEngine2D;
+
+// Which batches keep spawning when a ParticleEngine2D is close to its particle budget
+enum class ParticlePriority { LOW, NORMAL, HIGH };
+
 class Particle2D {
 public:
     glm::vec2 position = glm::vec2(0.0f);
@@ -24,11 +31,28 @@ inline void defaultParticleUpdate(Particle2D& particle, float deltaTime)
     particle.position += particle.velocity * deltaTime;
 }
 
+// Where a batch keeps each particle property, indexed by particle
+struct ParticleArrays {
+    float* positionX;
+    float* positionY;
+    float* velocityX;
+    float* velocityY;
+    float* life;
+    float* size;
+    ColorRGBA8* colors;
+};
+
+// Particles are stored as a structure of arrays, with the live ones packed at the front, so spawning
+// is O(1) and update and draw only touch live particles. The default update integrates and decays
+// several particles per instruction with SSE or AVX, or one at a time when BENGINE_NO_SIMD is defined.
+// A custom update function gets each live particle copied into a Particle2D and back.
+// PolicyParticleBatch2D replaces updateRange() with one that has its update compiled in.
 class ParticleBatch2D
 {
+    friend class ParticleEngine2D;
 public:
 	ParticleBatch2D();
-	~ParticleBatch2D();
+	virtual ~ParticleBatch2D();
 
 	void init(
         int maxParticles,
@@ -37,25 +61,72 @@ public:
         std::function<void(Particle2D&, float)> updateFunc = defaultParticleUpdate
     );
 
+    // Moves and ages the live particles, collides them and removes the ones that died
     void update(float deltaTime);
 
+    // Makes the particles hit the static fixtures of world, nullptr to stop. They bounce off with restitution
+    // of their speed, or die. The world must not be stepped during update().
+    void setCollision(const b2World* world,
+                      ParticleCollisionResponse response = ParticleCollisionResponse::BOUNCE,
+                      float restitution = 0.5f);
+
     void draw(SpriteBatch* spriteBatch);
 
-	void addParticle(
+    // Returns false without spawning when the batch is full or the engine's budget holds it back
+	bool addParticle(
 		const glm::vec2& position,
 		const glm::vec2& velocity,
 		const ColorRGBA8& color,
         float size
 	);
+
+    size_t getNumParticles() const { return m_numParticles; }
+    const GLTexture& getTexture() const { return m_texture; }
+    ParticlePriority getPriority() const { return m_priority; }
+
+protected:
+    // Moves and ages particles [begin, end), with begin a multiple of 8. Only touches those particles,
+    // so ParticleEngine2D can update several ranges of a batch at once.
+    virtual void updateRange(size_t begin, size_t end, float deltaTime);
+    // Custom update functions may keep state, so they get the whole batch on one thread
+    virtual bool canSplitUpdate() const { return !m_hasCustomUpdate; }
+
+    ParticleArrays getArrays();
+    // Swaps the last live particle into each dead one. Call at the end of update().
+    void removeDeadParticles();
+
+    // One broadphase query for the whole batch, then any number of ranges can be collided
+    bool hasCollision() const { return m_collider.isEnabled(); }
+    void findCollisionFixtures(float deltaTime);
+    void collideRange(size_t begin, size_t end, float deltaTime);
+
+	float m_decayRate = 0.1f;
+    size_t m_numParticles = 0; ///< Live particles, at the front of the arrays
+
+
 private:
-    int findFreeParticle();
-    
+    void updateCustom(size_t begin, size_t end, float deltaTime);
+
     std::function<void(Particle2D&, float)> m_updateFunc;
-	float m_decayRate = 0.1f;
-	Particle2D* m_particles = nullptr;
+    bool m_hasCustomUpdate = false;
 	int m_maxParticles = 0;
-    int m_lastFreeParticle = 0;
     GLTexture m_texture;
+
+    // Set by the ParticleEngine2D the batch is added to
+    ParticleEngine2D* m_engine = nullptr;
+    ParticlePriority m_priority = ParticlePriority::NORMAL;
+    float m_spawnCredit = 0.0f; ///< Spreads the spawns the engine allows over the spawn calls
+
+    ParticleCollider2D m_collider;
+
+    // Padded to a multiple of 8, so the update kernel has no remainder loop
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+    std::vector<float> m_life;
+    std::vector<float> m_size;
+    std::vector<ColorRGBA8> m_colors;
 };
 
 }
\ No newline at end of file
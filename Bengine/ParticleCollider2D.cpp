@@ -0,0 +1,332 @@
+#include "ParticleCollider2D.h"
+#include "ParticleBatch2D.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#if !defined(BENGINE_NO_SIMD) && (defined(__SSE2__) || defined(__AVX__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define BENGINE_COLLIDE_SSE
+#endif
+
+namespace Bengine {
+
+// How far off a surface particles are put when they hit it, so they never start the next move on the wrong side
+const float SKIN = 0.001f;
+
+#if defined(BENGINE_COLLIDE_SSE)
+// a where mask is set, b elsewhere
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+ParticleCollider2D::ParticleCollider2D()
+{
+    // Empty
+}
+
+
+ParticleCollider2D::~ParticleCollider2D()
+{
+    // Empty
+}
+
+
+void ParticleCollider2D::init(const b2World* world, ParticleCollisionResponse response, float restitution)
+{
+    m_world = world;
+    m_response = response;
+    m_restitution = restitution;
+    m_boxes.clear();
+    m_segments.clear();
+}
+
+
+void ParticleCollider2D::findFixtures(const ParticleArrays& particles, size_t count, float deltaTime)
+{
+    m_boxes.clear();
+    m_segments.clear();
+    m_chains.clear();
+    if (!m_world || count == 0) return;
+
+    // Bounds of the particle centers, before and after moving
+    float minX = FLT_MAX, minY = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (size_t i = 0; i < count; i++) {
+        float half = particles.size[i] * 0.5f;
+        float x = particles.positionX[i] + half;
+        float y = particles.positionY[i] + half;
+        float previousX = x - particles.velocityX[i] * deltaTime;
+        float previousY = y - particles.velocityY[i] * deltaTime;
+        minX = std::min(minX, std::min(x, previousX));
+        minY = std::min(minY, std::min(y, previousY));
+        maxX = std::max(maxX, std::max(x, previousX));
+        maxY = std::max(maxY, std::max(y, previousY));
+    }
+
+    m_bounds.lowerBound.Set(minX, minY);
+    m_bounds.upperBound.Set(maxX, maxY);
+    m_world->QueryAABB(this, m_bounds);
+}
+
+
+bool ParticleCollider2D::ReportFixture(b2Fixture* fixture)
+{
+    if (fixture->IsSensor() || fixture->GetBody()->GetType() != b2_staticBody) return true;
+
+    const b2Shape* shape = fixture->GetShape();
+    const b2Transform& transform = fixture->GetBody()->GetTransform();
+
+    switch (shape->GetType()) {
+        case b2Shape::e_edge: {
+            const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+            addSegment(b2Mul(transform, edge->m_vertex1), b2Mul(transform, edge->m_vertex2));
+            break;
+        }
+        case b2Shape::e_chain: {
+            if (std::find(m_chains.begin(), m_chains.end(), fixture) != m_chains.end()) break;
+            m_chains.push_back(fixture);
+
+            // Only the edges near the particles
+            const b2ChainShape* chain = (const b2ChainShape*)shape;
+            b2EdgeShape edge;
+            for (int32 i = 0; i < chain->GetChildCount(); i++) {
+                b2AABB aabb;
+                chain->ComputeAABB(&aabb, transform, i);
+                if (!b2TestOverlap(aabb, m_bounds)) continue;
+
+                chain->GetChildEdge(&edge, i);
+                addSegment(b2Mul(transform, edge.m_vertex1), b2Mul(transform, edge.m_vertex2));
+            }
+            break;
+        }
+        default: {
+            // Exact for the axis aligned boxes levels are made of, close enough for the rest.
+            // Not the fixture's own AABB, that one is fattened for the broadphase.
+            b2AABB aabb;
+            shape->ComputeAABB(&aabb, transform, 0);
+            m_boxes.push_back(aabb);
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+void ParticleCollider2D::addSegment(const b2Vec2& a, const b2Vec2& b)
+{
+    b2Vec2 e = b - a;
+    float length = e.Length();
+    if (length < b2_epsilon) return;
+
+    Segment segment;
+    segment.ax = a.x;
+    segment.ay = a.y;
+    segment.ex = e.x;
+    segment.ey = e.y;
+    segment.nx = -e.y / length;
+    segment.ny = e.x / length;
+    m_segments.push_back(segment);
+}
+
+
+void ParticleCollider2D::collide(const ParticleArrays& particles, size_t begin, size_t end, float deltaTime) const
+{
+    if (m_boxes.empty() && m_segments.empty()) return;
+
+    const bool kill = (m_response == ParticleCollisionResponse::KILL);
+
+    // Particles are tested at their center, along the move they made this update, so fast ones can't skip through
+    // thin platforms. The first shape the move reaches is the one it hits, the others may be behind it. A hit puts
+    // the particle where it met the surface, just off it, and reflects its speed into the surface.
+#if defined(BENGINE_COLLIDE_SSE)
+    // Four particles at a time against one shape. Shapes are few, so they're the inner loop and particles are loaded once.
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 halfScale = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 skin = _mm_set1_ps(SKIN);
+    const __m128 negativeSkin = _mm_set1_ps(-SKIN);
+    const __m128 bounce = _mm_set1_ps(1.0f + m_restitution);
+
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 half = _mm_mul_ps(_mm_loadu_ps(particles.size + i), halfScale);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(particles.positionX + i), half);
+        __m128 y = _mm_add_ps(_mm_loadu_ps(particles.positionY + i), half);
+        __m128 vx = _mm_loadu_ps(particles.velocityX + i);
+        __m128 vy = _mm_loadu_ps(particles.velocityY + i);
+        __m128 dx = _mm_mul_ps(vx, dt);
+        __m128 dy = _mm_mul_ps(vy, dt);
+        __m128 previousX = _mm_sub_ps(x, dx);
+        __m128 previousY = _mm_sub_ps(y, dy);
+        // Not moving on an axis gives infinities, which the slab test handles
+        __m128 inverseDx = _mm_div_ps(one, dx);
+        __m128 inverseDy = _mm_div_ps(one, dy);
+
+        // The earliest hit so far, where it puts the particle and the normal it bounces off.
+        // Lanes that hit nothing keep a zero normal.
+        __m128 firstT = _mm_set1_ps(2.0f);
+        __m128 hitX = x, hitY = y;
+        __m128 normalX = zero, normalY = zero;
+
+        for (auto& box : m_boxes) {
+            const __m128 minX = _mm_set1_ps(box.lowerBound.x);
+            const __m128 minY = _mm_set1_ps(box.lowerBound.y);
+            const __m128 maxX = _mm_set1_ps(box.upperBound.x);
+            const __m128 maxY = _mm_set1_ps(box.upperBound.y);
+
+            // Where along the move it enters and leaves each slab. It hits when it's in both at once during the move.
+            __m128 tx1 = _mm_mul_ps(_mm_sub_ps(minX, previousX), inverseDx);
+            __m128 tx2 = _mm_mul_ps(_mm_sub_ps(maxX, previousX), inverseDx);
+            __m128 ty1 = _mm_mul_ps(_mm_sub_ps(minY, previousY), inverseDy);
+            __m128 ty2 = _mm_mul_ps(_mm_sub_ps(maxY, previousY), inverseDy);
+            __m128 enterX = _mm_min_ps(tx1, tx2);
+            __m128 enterY = _mm_min_ps(ty1, ty2);
+            __m128 enter = _mm_max_ps(enterX, enterY);
+            __m128 exit = _mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2));
+            __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(enter, zero), _mm_cmple_ps(enter, one)),
+                                    _mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmplt_ps(enter, firstT)));
+            if (_mm_movemask_ps(hit) == 0) continue;
+
+            // Came in through the left or right side when it reached the x slab last
+            __m128 side = _mm_cmpgt_ps(enterX, enterY);
+            __m128 movingRight = _mm_cmpgt_ps(dx, zero);
+            __m128 movingUp = _mm_cmpgt_ps(dy, zero);
+            __m128 faceX = select(movingRight, _mm_sub_ps(minX, skin), _mm_add_ps(maxX, skin));
+            __m128 faceY = select(movingUp, _mm_sub_ps(minY, skin), _mm_add_ps(maxY, skin));
+            __m128 boxHitX = select(side, faceX, _mm_add_ps(previousX, _mm_mul_ps(dx, enter)));
+            __m128 boxHitY = select(side, _mm_add_ps(previousY, _mm_mul_ps(dy, enter)), faceY);
+            __m128 boxNormalX = _mm_and_ps(side, select(movingRight, minusOne, one));
+            __m128 boxNormalY = _mm_andnot_ps(side, select(movingUp, minusOne, one));
+
+            firstT = select(hit, enter, firstT);
+            hitX = select(hit, boxHitX, hitX);
+            hitY = select(hit, boxHitY, hitY);
+            normalX = select(hit, boxNormalX, normalX);
+            normalY = select(hit, boxNormalY, normalY);
+        }
+
+        for (auto& segment : m_segments) {
+            const __m128 ex = _mm_set1_ps(segment.ex);
+            const __m128 ey = _mm_set1_ps(segment.ey);
+
+            // Solves previous + t * d = a + u * e, a hit when both are in [0, 1]. Particles moving along
+            // the segment or not at all divide by 0 and compare false.
+            __m128 wx = _mm_sub_ps(_mm_set1_ps(segment.ax), previousX);
+            __m128 wy = _mm_sub_ps(_mm_set1_ps(segment.ay), previousY);
+            __m128 denominator = _mm_sub_ps(_mm_mul_ps(dx, ey), _mm_mul_ps(dy, ex));
+            __m128 t = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(wx, ey), _mm_mul_ps(wy, ex)), denominator);
+            __m128 u = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(wx, dy), _mm_mul_ps(wy, dx)), denominator);
+            __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one)),
+                                    _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+            hit = _mm_and_ps(hit, _mm_cmplt_ps(t, firstT));
+            if (_mm_movemask_ps(hit) == 0) continue;
+
+            // Backed off the segment on the side it came from
+            const __m128 nx = _mm_set1_ps(segment.nx);
+            const __m128 ny = _mm_set1_ps(segment.ny);
+            __m128 distance = _mm_add_ps(_mm_mul_ps(wx, nx), _mm_mul_ps(wy, ny));
+            __m128 offset = select(_mm_cmpgt_ps(distance, zero), negativeSkin, skin);
+
+            firstT = select(hit, t, firstT);
+            hitX = select(hit, _mm_add_ps(_mm_add_ps(_mm_set1_ps(segment.ax), _mm_mul_ps(ex, u)), _mm_mul_ps(nx, offset)), hitX);
+            hitY = select(hit, _mm_add_ps(_mm_add_ps(_mm_set1_ps(segment.ay), _mm_mul_ps(ey, u)), _mm_mul_ps(ny, offset)), hitY);
+            normalX = select(hit, nx, normalX);
+            normalY = select(hit, ny, normalY);
+        }
+
+        // Most particles hit nothing, and their memory is left alone
+        __m128 hit = _mm_cmple_ps(firstT, one);
+        if (_mm_movemask_ps(hit) == 0) continue;
+
+        if (kill) {
+            _mm_storeu_ps(particles.life + i, _mm_andnot_ps(hit, _mm_loadu_ps(particles.life + i)));
+            continue;
+        }
+
+        __m128 speed = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vx, normalX), _mm_mul_ps(vy, normalY)), bounce);
+        _mm_storeu_ps(particles.positionX + i, _mm_sub_ps(select(hit, hitX, x), half));
+        _mm_storeu_ps(particles.positionY + i, _mm_sub_ps(select(hit, hitY, y), half));
+        _mm_storeu_ps(particles.velocityX + i, _mm_sub_ps(vx, _mm_mul_ps(speed, normalX)));
+        _mm_storeu_ps(particles.velocityY + i, _mm_sub_ps(vy, _mm_mul_ps(speed, normalY)));
+    }
+#else
+    for (size_t i = begin; i < end; i++) {
+        float half = particles.size[i] * 0.5f;
+        float x = particles.positionX[i] + half;
+        float y = particles.positionY[i] + half;
+        float dx = particles.velocityX[i] * deltaTime;
+        float dy = particles.velocityY[i] * deltaTime;
+        float previousX = x - dx;
+        float previousY = y - dy;
+        if (dx == 0.0f && dy == 0.0f) continue;
+
+        float firstT = 2.0f;
+        float hitX = x, hitY = y;
+        float normalX = 0.0f, normalY = 0.0f;
+
+        for (auto& box : m_boxes) {
+            float tx1 = (box.lowerBound.x - previousX) / dx;
+            float tx2 = (box.upperBound.x - previousX) / dx;
+            float ty1 = (box.lowerBound.y - previousY) / dy;
+            float ty2 = (box.upperBound.y - previousY) / dy;
+            float enterX = std::min(tx1, tx2);
+            float enterY = std::min(ty1, ty2);
+            float enter = std::max(enterX, enterY);
+            float exit = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+            if (!(enter >= 0.0f && enter <= 1.0f && enter <= exit && enter < firstT)) continue;
+
+            firstT = enter;
+            if (enterX > enterY) {
+                hitX = (dx > 0.0f) ? box.lowerBound.x - SKIN : box.upperBound.x + SKIN;
+                hitY = previousY + dy * enter;
+                normalX = (dx > 0.0f) ? -1.0f : 1.0f;
+                normalY = 0.0f;
+            }
+            else {
+                hitX = previousX + dx * enter;
+                hitY = (dy > 0.0f) ? box.lowerBound.y - SKIN : box.upperBound.y + SKIN;
+                normalX = 0.0f;
+                normalY = (dy > 0.0f) ? -1.0f : 1.0f;
+            }
+        }
+
+        for (auto& segment : m_segments) {
+            float wx = segment.ax - previousX;
+            float wy = segment.ay - previousY;
+            float denominator = dx * segment.ey - dy * segment.ex;
+            if (denominator == 0.0f) continue;
+
+            float t = (wx * segment.ey - wy * segment.ex) / denominator;
+            float u = (wx * dy - wy * dx) / denominator;
+            if (t < 0.0f || t > 1.0f || t >= firstT || u < 0.0f || u > 1.0f) continue;
+
+            float offset = (wx * segment.nx + wy * segment.ny > 0.0f) ? -SKIN : SKIN;
+            firstT = t;
+            hitX = segment.ax + segment.ex * u + segment.nx * offset;
+            hitY = segment.ay + segment.ey * u + segment.ny * offset;
+            normalX = segment.nx;
+            normalY = segment.ny;
+        }
+
+        if (firstT > 1.0f) continue;
+
+        if (kill) {
+            particles.life[i] = 0.0f;
+            continue;
+        }
+
+        float speed = (particles.velocityX[i] * normalX + particles.velocityY[i] * normalY) * (1.0f + m_restitution);
+        particles.positionX[i] = hitX - half;
+        particles.positionY[i] = hitY - half;
+        particles.velocityX[i] -= speed * normalX;
+        particles.velocityY[i] -= speed * normalY;
+    }
+#endif
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <vector>
+
+namespace Bengine {
+
+struct ParticleArrays;
+
+// What happens to a particle that hits the world
+enum class ParticleCollisionResponse { BOUNCE, KILL };
+
+// Collides particles with the static fixtures of a Box2D world. Particles never get bodies, so any number of them
+// stay out of the broadphase. Each update one query over the bounds of the particles collects the fixtures near them,
+// polygons and circles as boxes and edges and chains as segments, and then every particle is tested against those.
+class ParticleCollider2D : public b2QueryCallback
+{
+public:
+    ParticleCollider2D();
+    ~ParticleCollider2D();
+
+    // A null world turns collision off. Bouncing particles keep restitution of their speed into the surface.
+    void init(const b2World* world, ParticleCollisionResponse response, float restitution);
+
+    bool isEnabled() const { return m_world != nullptr; }
+
+    // Collects the fixtures near particles [0, count), where they are and where they were before moving
+    // by their velocity * deltaTime. Once per update, after moving them and with no world step running.
+    void findFixtures(const ParticleArrays& particles, size_t count, float deltaTime);
+
+    // Collides particles [begin, end) that moved by their velocity * deltaTime, with end - begin a multiple of 4.
+    // Killed particles get a life of 0. Only touches those particles, so ranges can be collided at once.
+    void collide(const ParticleArrays& particles, size_t begin, size_t end, float deltaTime) const;
+
+    virtual bool ReportFixture(b2Fixture* fixture) override;
+
+    size_t getNumBoxes() const { return m_boxes.size(); }
+    size_t getNumSegments() const { return m_segments.size(); }
+
+private:
+    struct Segment {
+        float ax, ay; ///< Start
+        float ex, ey; ///< End - start
+        float nx, ny; ///< Unit normal
+    };
+
+    void addSegment(const b2Vec2& a, const b2Vec2& b);
+
+    const b2World* m_world = nullptr;
+    ParticleCollisionResponse m_response = ParticleCollisionResponse::BOUNCE;
+    float m_restitution = 0.5f;
+
+    b2AABB m_bounds; ///< Of the current query
+    std::vector<b2AABB> m_boxes;
+    std::vector<Segment> m_segments;
+    std::vector<const b2Fixture*> m_chains; ///< Chains already added, the query reports them once per edge
+};
+
+}
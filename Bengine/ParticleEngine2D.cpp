@@ -1,9 +1,20 @@
 #include "ParticleEngine2D.h"
 #include "ParticleBatch2D.h"
+#include "Profiler.h"
 #include "SpriteBatch.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
 
 namespace Bengine {
 
+// Share of the budget each priority can fill, by ParticlePriority
+const float PRIORITY_SHARES[] = { 0.5f, 0.8f, 1.0f };
+// How far into its share a priority gets before its spawns are thinned out
+const float THROTTLE_START = 0.75f;
+// Particles per update task. Batches bigger than this are split. A multiple of 8.
+const size_t CHUNK_SIZE = 16384;
+
 ParticleEngine2D::ParticleEngine2D()
 {
     // Empty
@@ -18,30 +29,141 @@ ParticleEngine2D::~ParticleEngine2D()
 }
 
 
-void ParticleEngine2D::addParticleBatch(ParticleBatch2D* particleBatch)
+void ParticleEngine2D::addParticleBatch(ParticleBatch2D* particleBatch, ParticlePriority priority /* = ParticlePriority::NORMAL */)
 {
+    particleBatch->m_engine = this;
+    particleBatch->m_priority = priority;
     m_batches.push_back(particleBatch);
+    m_numParticles += particleBatch->getNumParticles();
+    m_isDrawOrderDirty = true;
 }
 
 
 void ParticleEngine2D::update(float deltaTime)
 {
+    BENGINE_PROFILE_ZONE("ParticleEngine2D::update");
+
+    if (m_threadPool) {
+        updateParallel(deltaTime);
+        return;
+    }
+
+    m_numParticles = 0;
     for (auto& batch : m_batches) {
         batch->update(deltaTime);
+        m_numParticles += batch->getNumParticles();
     }
 }
 
 
 void ParticleEngine2D::draw(SpriteBatch* spriteBatch)
 {
-    for (auto& batch : m_batches) {
-        spriteBatch->begin();
+    // Sorting the batches once replaces sorting every particle, the sprite batch
+    // only has to merge neighbouring particles with the same texture
+    if (m_isDrawOrderDirty) {
+        m_drawOrder = m_batches;
+        std::stable_sort(m_drawOrder.begin(), m_drawOrder.end(), [](ParticleBatch2D* a, ParticleBatch2D* b) {
+            return a->getTexture().id < b->getTexture().id;
+        });
+        m_isDrawOrderDirty = false;
+    }
 
+    spriteBatch->begin(GlyphSortType::NONE);
+
+    for (auto& batch : m_drawOrder) {
         batch->draw(spriteBatch);
+    }
+
+    spriteBatch->end();
+    spriteBatch->renderBatch();
+}
+
+
+void ParticleEngine2D::updateParallel(float deltaTime)
+{
+    // Every task only touches its own particles, and dead ones are removed in batch order
+    // after the join, so the thread count never changes the outcome
+    m_splitBatches.clear();
+    for (auto& batch : m_batches) {
+        const size_t numParticles = batch->getNumParticles();
+        if (numParticles == 0) continue;
+
+        if (numParticles <= CHUNK_SIZE || !batch->canSplitUpdate()) {
+            m_threadPool->addTask([batch, deltaTime]() {
+                BENGINE_PROFILE_ZONE("ParticleBatch2D::update");
+                batch->update(deltaTime);
+            });
+            continue;
+        }
+
+        for (size_t begin = 0; begin < numParticles; begin += CHUNK_SIZE) {
+            const size_t end = std::min(begin + CHUNK_SIZE, numParticles);
+            m_threadPool->addTask([batch, begin, end, deltaTime]() {
+                BENGINE_PROFILE_ZONE("ParticleBatch2D::updateRange");
+                batch->updateRange(begin, end, deltaTime);
+            });
+        }
+        m_splitBatches.push_back(batch);
+    }
 
-        spriteBatch->end();
-        spriteBatch->renderBatch();
+    m_threadPool->waitForTasks();
+
+    // Split batches collide once all their particles have moved, with one query each
+    bool isColliding = false;
+    for (auto& batch : m_splitBatches) {
+        if (!batch->hasCollision()) continue;
+
+        batch->findCollisionFixtures(deltaTime);
+        const size_t numParticles = batch->getNumParticles();
+        for (size_t begin = 0; begin < numParticles; begin += CHUNK_SIZE) {
+            const size_t end = std::min(begin + CHUNK_SIZE, numParticles);
+            m_threadPool->addTask([batch, begin, end, deltaTime]() {
+                BENGINE_PROFILE_ZONE("ParticleBatch2D::collideRange");
+                batch->collideRange(begin, end, deltaTime);
+            });
+        }
+        isColliding = true;
+    }
+    if (isColliding) m_threadPool->waitForTasks();
+
+    for (auto& batch : m_splitBatches) {
+        batch->removeDeadParticles();
+    }
+
+    m_numParticles = 0;
+    for (auto& batch : m_batches) {
+        m_numParticles += batch->getNumParticles();
+    }
+}
+
+
+bool ParticleEngine2D::trySpawn(ParticlePriority priority, float& spawnCredit)
+{
+    if (m_budget == 0) {
+        m_numParticles++;
+        return true;
     }
+
+    const float limit = m_budget * PRIORITY_SHARES[(int)priority];
+    const float throttleStart = limit * THROTTLE_START;
+    const float numParticles = (float)m_numParticles;
+
+    // Fraction of spawns to let through, from 1 at the start of throttling down to 0 at the limit
+    float rate = 1.0f;
+    if (numParticles >= limit) {
+        rate = 0.0f;
+    }
+    else if (numParticles > throttleStart) {
+        rate = (limit - numParticles) / (limit - throttleStart);
+    }
+
+    // Every call adds the rate, and a spawn takes a whole one, so the spawns that do go through are evenly spread
+    spawnCredit = std::min(spawnCredit + rate, 1.0f);
+    if (spawnCredit < 1.0f) return false;
+
+    spawnCredit -= 1.0f;
+    m_numParticles++;
+    return true;
 }
 
 
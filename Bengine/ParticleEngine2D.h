@@ -3,10 +3,12 @@
 #include <iostream>
 #include <vector>
 
+#include "ParticleBatch2D.h"
+
 namespace Bengine {
 
-class ParticleBatch2D;
 class SpriteBatch;
+class ThreadPool;
 
 class ParticleEngine2D
 {
@@ -15,14 +17,40 @@ public:
 	~ParticleEngine2D();
 
     // After adding a particle batch, the ParticleEngine2D becomes responsible for deallocation
-    void addParticleBatch(ParticleBatch2D* particleBatch);
+    // When the engine nears its budget, LOW priority batches stop spawning first and HIGH ones last.
+    void addParticleBatch(ParticleBatch2D* particleBatch, ParticlePriority priority = ParticlePriority::NORMAL);
+
+    // Caps the live particles of all batches together. 0, the default, means no cap.
+    void setParticleBudget(size_t budget) { m_budget = budget; }
+    size_t getParticleBudget() const { return m_budget; }
+    size_t getNumParticles() const { return m_numParticles; }
 
+    // Updates every batch. With a thread pool, batches and ranges of big batches are spread over it,
+    // and it returns once they're all done. The results are the same for any number of threads.
     void update(float deltaTime);
 
+    // Pool to update on, nullptr to update on the calling thread. The engine doesn't own it.
+    void setThreadPool(ThreadPool* threadPool) { m_threadPool = threadPool; }
+
+    // Draws every batch in one sprite batch pass, so all particles are uploaded at once and there's
+    // one draw call per texture. Batches are drawn grouped by texture instead of in the order they were added.
     void draw(SpriteBatch* spriteBatch);
 
 private:
+    friend class ParticleBatch2D;
+
+    // Asked by batches before each spawn. Each priority gets a share of the budget, and near the end of
+    // its share only some of its spawns go through, fewer the closer it gets, so bursts thin out instead of cutting off.
+    bool trySpawn(ParticlePriority priority, float& spawnCredit);
+    void updateParallel(float deltaTime);
+
     std::vector<ParticleBatch2D *> m_batches;
+    ThreadPool* m_threadPool = nullptr;
+    std::vector<ParticleBatch2D *> m_splitBatches; ///< Batches updated in several tasks, for updateParallel()
+    std::vector<ParticleBatch2D *> m_drawOrder; ///< m_batches sorted by texture
+    bool m_isDrawOrderDirty = false;
+    size_t m_budget = 0;
+    size_t m_numParticles = 0; ///< Live particles, counted in update() and kept up to date by trySpawn()
 };
 
 
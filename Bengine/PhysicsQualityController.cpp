@@ -0,0 +1,161 @@
+#include "PhysicsQualityController.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+namespace Bengine {
+
+const float SMOOTHING = 0.1f; ///< How much of each new frame goes into the averages
+const int LOWER_DELAY = 15; ///< Frames to wait after a change before lowering again
+const int RAISE_DELAY = 288; ///< Frames to wait after a change before raising again, two seconds at 144 FPS
+const float RAISE_HEADROOM = 0.8f; ///< Only raise if the estimated new time fits in this much of the budget
+
+void PhysicsQualityController::init(float budget, const PhysicsQuality& minQuality, const PhysicsQuality& maxQuality, const PhysicsQuality& startQuality)
+{
+    m_minQuality = minQuality;
+    m_maxQuality = maxQuality;
+
+    m_stats = PhysicsStats();
+    m_stats.budget = budget;
+    m_stats.quality.velocityIterations = std::min(std::max(startQuality.velocityIterations, minQuality.velocityIterations), maxQuality.velocityIterations);
+    m_stats.quality.positionIterations = std::min(std::max(startQuality.positionIterations, minQuality.positionIterations), maxQuality.positionIterations);
+    m_stats.quality.subSteps = std::min(std::max(startQuality.subSteps, minQuality.subSteps), maxQuality.subSteps);
+
+    m_frameTime = 0.0f;
+    m_frameVelocityTime = 0.0f;
+    m_framePositionTime = 0.0f;
+    m_numFrameSteps = 0;
+    m_velocityTime = 0.0f;
+    m_positionTime = 0.0f;
+    m_framesSinceChange = 0;
+    m_hasFrameTime = false;
+}
+
+void PhysicsQualityController::step(b2World* world, float timeStep)
+{
+    const PhysicsQuality& q = m_stats.quality;
+
+    // Forces are applied once per fixed step, so they have to survive the substeps
+    if (q.subSteps > 1) world->SetAutoClearForces(false);
+
+    float subStep = timeStep / q.subSteps;
+    for (int i = 0; i < q.subSteps; i++) {
+        {
+            BENGINE_PROFILE_ZONE("b2World::Step");
+            world->Step(subStep, q.velocityIterations, q.positionIterations);
+        }
+
+        const b2Profile& profile = world->GetProfile();
+        m_frameTime += profile.step;
+        m_frameVelocityTime += profile.solveVelocity;
+        m_framePositionTime += profile.solvePosition;
+    }
+
+    if (q.subSteps > 1) {
+        world->ClearForces();
+        world->SetAutoClearForces(true);
+    }
+
+    m_numFrameSteps++;
+}
+
+bool PhysicsQualityController::endFrame()
+{
+    m_framesSinceChange++;
+
+    // Frames without a step say nothing about what a step costs
+    if (m_numFrameSteps == 0) return false;
+
+    m_stats.lastFrameTime = m_frameTime;
+    if (!m_hasFrameTime) {
+        m_stats.frameTime = m_frameTime;
+        m_velocityTime = m_frameVelocityTime;
+        m_positionTime = m_framePositionTime;
+        m_hasFrameTime = true;
+    }
+    else {
+        m_stats.frameTime += (m_frameTime - m_stats.frameTime) * SMOOTHING;
+        m_velocityTime += (m_frameVelocityTime - m_velocityTime) * SMOOTHING;
+        m_positionTime += (m_framePositionTime - m_positionTime) * SMOOTHING;
+    }
+    if (m_frameTime > m_stats.budget) m_stats.numOverruns++;
+
+    m_frameTime = 0.0f;
+    m_frameVelocityTime = 0.0f;
+    m_framePositionTime = 0.0f;
+    m_numFrameSteps = 0;
+
+    PhysicsQuality quality = m_stats.quality;
+    if (m_stats.frameTime > m_stats.budget) {
+        if (m_framesSinceChange < LOWER_DELAY) return false;
+
+        // Drop as far as it takes in one go, a heavy scene shouldn't wait out several delays
+        while (estimateFrameTime(quality) > m_stats.budget && lowerQuality(quality)) {}
+    }
+    else {
+        if (m_framesSinceChange < RAISE_DELAY || !raiseQuality(quality)) return false;
+
+        if (estimateFrameTime(quality) > m_stats.budget * RAISE_HEADROOM) return false;
+    }
+    if (quality == m_stats.quality) return false;
+
+    // Start the averages off where the new quality should be, instead of waiting for them to catch up
+    const PhysicsQuality& old = m_stats.quality;
+    float newFrameTime = estimateFrameTime(quality);
+    m_velocityTime *= (float)(quality.subSteps * quality.velocityIterations) / (old.subSteps * old.velocityIterations);
+    m_positionTime *= (float)(quality.subSteps * quality.positionIterations) / (old.subSteps * old.positionIterations);
+    m_stats.frameTime = newFrameTime;
+
+    m_stats.quality = quality;
+    m_stats.numQualityChanges++;
+    m_framesSinceChange = 0;
+    return true;
+}
+
+bool PhysicsQualityController::lowerQuality(PhysicsQuality& quality) const
+{
+    if (quality.subSteps > m_minQuality.subSteps) {
+        quality.subSteps--;
+    }
+    else if (quality.velocityIterations > m_minQuality.velocityIterations) {
+        quality.velocityIterations--;
+    }
+    else if (quality.positionIterations > m_minQuality.positionIterations) {
+        quality.positionIterations--;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool PhysicsQualityController::raiseQuality(PhysicsQuality& quality) const
+{
+    if (quality.positionIterations < m_maxQuality.positionIterations) {
+        quality.positionIterations++;
+    }
+    else if (quality.velocityIterations < m_maxQuality.velocityIterations) {
+        quality.velocityIterations++;
+    }
+    else if (quality.subSteps < m_maxQuality.subSteps) {
+        quality.subSteps++;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+float PhysicsQualityController::estimateFrameTime(const PhysicsQuality& quality) const
+{
+    const PhysicsQuality& current = m_stats.quality;
+
+    // Iterations cost about the same each, the rest of a step doesn't depend on them
+    float velocityIteration = m_velocityTime / (current.subSteps * current.velocityIterations);
+    float positionIteration = m_positionTime / (current.subSteps * current.positionIterations);
+    float subStepOverhead = std::max(m_stats.frameTime - m_velocityTime - m_positionTime, 0.0f) / current.subSteps;
+
+    return quality.subSteps * (subStepOverhead + quality.velocityIterations * velocityIteration + quality.positionIterations * positionIteration);
+}
+
+}
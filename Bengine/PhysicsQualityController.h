@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+
+namespace Bengine {
+
+struct PhysicsQuality {
+    PhysicsQuality() {}
+    PhysicsQuality(int VelocityIterations, int PositionIterations, int SubSteps) :
+        velocityIterations(VelocityIterations), positionIterations(PositionIterations), subSteps(SubSteps)
+    {
+        // Empty
+    }
+
+    bool operator==(const PhysicsQuality& other) const {
+        return velocityIterations == other.velocityIterations && positionIterations == other.positionIterations && subSteps == other.subSteps;
+    }
+    bool operator!=(const PhysicsQuality& other) const { return !(*this == other); }
+
+    int velocityIterations = 6;
+    int positionIterations = 2;
+    int subSteps = 1; ///< World steps per fixed step
+};
+
+struct PhysicsStats {
+    PhysicsQuality quality;
+    float budget = 0.0f; ///< Milliseconds of physics per frame
+    float frameTime = 0.0f; ///< Smoothed milliseconds of physics per frame
+    float lastFrameTime = 0.0f;
+    unsigned int numOverruns = 0; ///< Frames whose physics took longer than the budget
+    unsigned int numQualityChanges = 0;
+};
+
+// Steps a world with as many solver iterations and substeps as fit in a per-frame time budget.
+// b2World::GetProfile() splits each step into velocity iterations, position iterations and the rest,
+// which gives an estimate of what any other quality would cost.
+// Over budget, quality drops until the estimate fits: substeps first, then velocity iterations,
+// then position iterations. Spare time buys them back one at a time in the opposite order.
+class PhysicsQualityController
+{
+public:
+    // Budget is in milliseconds per frame. Every count in minQuality has to be at least 1.
+    void init(float budget, const PhysicsQuality& minQuality, const PhysicsQuality& maxQuality, const PhysicsQuality& startQuality);
+
+    // Use instead of world->Step(). Forces last for every substep.
+    void step(b2World* world, float timeStep);
+
+    // Compares this frame's steps with the budget and changes the quality if needed.
+    // Call once per frame. Returns true if the quality changed.
+    bool endFrame();
+
+    const PhysicsQuality& getQuality() const { return m_stats.quality; }
+    const PhysicsStats& getStats() const { return m_stats; }
+
+private:
+    bool lowerQuality(PhysicsQuality& quality) const;
+    bool raiseQuality(PhysicsQuality& quality) const;
+
+    // Milliseconds per frame quality would take, going by the averages
+    float estimateFrameTime(const PhysicsQuality& quality) const;
+
+    PhysicsQuality m_minQuality;
+    PhysicsQuality m_maxQuality;
+    PhysicsStats m_stats;
+
+    // Milliseconds so far this frame
+    float m_frameTime = 0.0f;
+    float m_frameVelocityTime = 0.0f;
+    float m_framePositionTime = 0.0f;
+    int m_numFrameSteps = 0;
+
+    // Smoothed milliseconds per frame. The total is in m_stats.
+    float m_velocityTime = 0.0f;
+    float m_positionTime = 0.0f;
+
+    int m_framesSinceChange = 0;
+    bool m_hasFrameTime = false; ///< False until the first frame with a step
+};
+
+}
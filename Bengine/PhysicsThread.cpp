@@ -0,0 +1,100 @@
+#include "PhysicsThread.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+namespace Bengine {
+
+typedef std::chrono::steady_clock Clock;
+
+static long long getClockTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+PhysicsThread::PhysicsThread() :
+    m_isRunning(false),
+    m_stepTime(0)
+{
+    // Empty
+}
+
+
+PhysicsThread::~PhysicsThread()
+{
+    stop();
+}
+
+
+void PhysicsThread::start(float timeStep, int maxSubSteps, std::function<void(float)> step)
+{
+    stop();
+
+    m_timeStep = timeStep;
+    m_maxSubSteps = maxSubSteps;
+    m_step = step;
+    m_stepTime = getClockTime();
+
+    m_isRunning = true;
+    m_thread = std::thread(&PhysicsThread::threadLoop, this);
+}
+
+void PhysicsThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        if (!m_isRunning) return;
+        m_isRunning = false;
+    }
+    m_wake.notify_all();
+
+    m_thread.join();
+    m_step = nullptr;
+}
+
+float PhysicsThread::getInterpolationAlpha() const
+{
+    float alpha = (float)((getClockTime() - m_stepTime) * 1e-9) / m_timeStep;
+    if (alpha < 0.0f) return 0.0f;
+    if (alpha > 1.0f) return 1.0f;
+    return alpha;
+}
+
+void PhysicsThread::threadLoop()
+{
+    const long long TIME_STEP = (long long)(m_timeStep * 1e9);
+    // Drop the time we can't catch up on, otherwise slow steps make even more steps
+    const long long MAX_ACCUMULATOR = TIME_STEP * m_maxSubSteps;
+
+    Profiler::setThreadName("Physics");
+
+    long long previousTime = getClockTime();
+    long long accumulator = 0;
+
+    std::unique_lock<std::mutex> wakeLock(m_wakeMutex);
+    while (m_isRunning) {
+        wakeLock.unlock();
+
+        long long time = getClockTime();
+        accumulator += time - previousTime;
+        previousTime = time;
+        if (accumulator > MAX_ACCUMULATOR) accumulator = MAX_ACCUMULATOR;
+
+        while (accumulator >= TIME_STEP) {
+            {
+                std::lock_guard<std::mutex> lock(m_stepMutex);
+                m_step(m_timeStep);
+            }
+            accumulator -= TIME_STEP;
+        }
+        m_stepTime = time - accumulator;
+
+        // Sleep until the next step is due
+        wakeLock.lock();
+        if (m_isRunning) {
+            m_wake.wait_for(wakeLock, std::chrono::nanoseconds(TIME_STEP - accumulator));
+        }
+    }
+}
+
+}
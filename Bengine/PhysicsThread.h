@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Bengine {
+
+// Runs fixed steps on a thread of its own, every timeStep seconds of real time,
+// so stepping overlaps with updating and drawing on the main thread.
+class PhysicsThread
+{
+public:
+    PhysicsThread();
+    ~PhysicsThread();
+
+    // Calls step(timeStep) on the new thread, at most maxSubSteps times in a row when it falls behind
+    void start(float timeStep, int maxSubSteps, std::function<void(float)> step);
+
+    // Lets the current step finish and joins the thread
+    void stop();
+
+    bool isRunning() const { return m_isRunning; }
+
+    // No step runs while the lock is held. Also works when the thread isn't running.
+    std::unique_lock<std::mutex> lockSteps() { return std::unique_lock<std::mutex>(m_stepMutex); }
+
+    // How far between the last step and the next one now is, from 0 to 1
+    float getInterpolationAlpha() const;
+
+private:
+    void threadLoop();
+
+    std::thread m_thread;
+    std::function<void(float)> m_step;
+    float m_timeStep = 1.0f / 144.0f;
+    int m_maxSubSteps = 8;
+
+    std::mutex m_stepMutex; ///< Held during each step
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake; ///< Cuts waiting for the next step short when stopping
+    std::atomic<bool> m_isRunning;
+    std::atomic<long long> m_stepTime; ///< Clock time the last step simulated up to, in nanoseconds
+};
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include "ParticleBatch2D.h"
+
+namespace Bengine {
+
+// Update policies change a particle before it moves. Any type with
+//   void operator()(Particle2D& particle, float deltaTime) const
+// works, the same as the update functions ParticleBatch2D takes. They only see live particles, and life
+// is in (0, 1] when they run. ParticleEngine2D may run them on several threads at once.
+
+// Accelerates particles, like gravity
+struct ParticleGravity {
+    ParticleGravity(const glm::vec2& acceleration = glm::vec2(0.0f, -9.8f)) : acceleration(acceleration) { }
+
+    void operator()(Particle2D& particle, float deltaTime) const {
+        particle.velocity += acceleration * deltaTime;
+    }
+
+    glm::vec2 acceleration;
+};
+
+// Takes drag of the velocity away per second
+struct ParticleDrag {
+    ParticleDrag(float drag = 1.0f) : drag(drag) { }
+
+    void operator()(Particle2D& particle, float deltaTime) const {
+        particle.velocity *= std::max(1.0f - drag * deltaTime, 0.0f);
+    }
+
+    float drag;
+};
+
+// Fades particles out over their life, from alpha to nothing
+struct ParticleFade {
+    ParticleFade(float alpha = 255.0f) : alpha(alpha) { }
+
+    void operator()(Particle2D& particle, float /*deltaTime*/) const {
+        particle.color.a = (GLubyte)(alpha * particle.life);
+    }
+
+    float alpha;
+};
+
+// Scales particles from startSize when they spawn to endSize when they die
+struct ParticleSizeOverLife {
+    ParticleSizeOverLife(float startSize = 1.0f, float endSize = 0.0f) : startSize(startSize), endSize(endSize) { }
+
+    void operator()(Particle2D& particle, float /*deltaTime*/) const {
+        particle.size = endSize + (startSize - endSize) * particle.life;
+    }
+
+    float startSize;
+    float endSize;
+};
+
+// Runs several policies in order, like ParticlePolicies<ParticleGravity, ParticleDrag, ParticleFade>
+template <typename... Policies>
+struct ParticlePolicies;
+
+template <>
+struct ParticlePolicies<> {
+    void operator()(Particle2D& /*particle*/, float /*deltaTime*/) const { }
+};
+
+template <typename First, typename... Rest>
+struct ParticlePolicies<First, Rest...> {
+    ParticlePolicies() { }
+    ParticlePolicies(const First& first, const Rest&... rest) : first(first), rest(rest...) { }
+
+    void operator()(Particle2D& particle, float deltaTime) const {
+        first(particle, deltaTime);
+        rest(particle, deltaTime);
+    }
+
+    First first;
+    ParticlePolicies<Rest...> rest;
+};
+
+// A particle batch with its update policy compiled into updateRange(), so the whole loop is inlined and can be vectorized.
+// Still a ParticleBatch2D, so ParticleEngine2D can hold it next to batches with other policies.
+template <typename UpdatePolicy>
+class PolicyParticleBatch2D : public ParticleBatch2D
+{
+public:
+    void init(int maxParticles, float decayRate, GLTexture texture, const UpdatePolicy& policy = UpdatePolicy()) {
+        ParticleBatch2D::init(maxParticles, decayRate, texture);
+        m_policy = policy;
+    }
+
+    UpdatePolicy& getPolicy() { return m_policy; }
+
+protected:
+    virtual void updateRange(size_t begin, size_t end, float deltaTime) override {
+        ParticleArrays p = getArrays();
+        updateParticles(m_policy, p.positionX + begin, p.positionY + begin, p.velocityX + begin, p.velocityY + begin,
+                        p.life + begin, p.size + begin, p.colors + begin, end - begin, deltaTime, m_decayRate * deltaTime);
+    }
+
+    // Policies only change the particle they're given, so ranges can be updated at once
+    virtual bool canSplitUpdate() const override { return true; }
+
+private:
+    // The arrays never overlap. Saying so lets the compiler vectorize without checking.
+    static void updateParticles(const UpdatePolicy& policy, float* __restrict positionX, float* __restrict positionY,
+                                float* __restrict velocityX, float* __restrict velocityY, float* __restrict life,
+                                float* __restrict size, ColorRGBA8* __restrict colors, size_t count, float deltaTime, float decay) {
+        for (size_t i = 0; i < count; i++) {
+            Particle2D particle;
+            particle.position = glm::vec2(positionX[i], positionY[i]);
+            particle.velocity = glm::vec2(velocityX[i], velocityY[i]);
+            particle.color = colors[i];
+            particle.life = life[i];
+            particle.size = size[i];
+
+            policy(particle, deltaTime);
+            particle.position += particle.velocity * deltaTime;
+
+            positionX[i] = particle.position.x;
+            positionY[i] = particle.position.y;
+            velocityX[i] = particle.velocity.x;
+            velocityY[i] = particle.velocity.y;
+            colors[i] = particle.color;
+            life[i] = particle.life - decay;
+            size[i] = particle.size;
+        }
+    }
+
+    UpdatePolicy m_policy;
+};
+
+}
@@ -0,0 +1,239 @@
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Bengine {
+
+typedef std::chrono::steady_clock Clock;
+
+struct ProfileEvent {
+    const char* name;
+    long long start;
+    long long end;
+};
+
+// Zones of one thread or track. Only one thread writes to it, the events before count are done
+// and can be read by the main thread while the thread keeps adding more.
+struct ProfileTrack {
+    std::vector<ProfileEvent> events;
+    std::atomic<size_t> count{ 0 };
+    std::atomic<int> capture{ 0 }; ///< Capture the events belong to
+    std::atomic<bool> isFree{ false }; ///< The thread has exited
+    bool isThread = true;
+    std::atomic<size_t> numDropped{ 0 };
+    int id = 0;
+    std::string name;
+};
+
+// Gives the track back when its thread exits
+struct ThreadTrackHandle {
+    ProfileTrack* track = nullptr;
+
+    ~ThreadTrackHandle() {
+        if (track) track->isFree.store(true, std::memory_order_release);
+    }
+};
+
+std::atomic<bool> Profiler::m_isRecording(false);
+
+// Only taken the first time a thread is seen, when adding a track and when writing
+static std::mutex tracksMutex;
+static std::vector<std::unique_ptr<ProfileTrack>> tracks;
+static int nextTrackId = 0;
+static thread_local ThreadTrackHandle threadTrack;
+
+static std::atomic<int> currentCapture(0);
+// Capture state, only touched by the main thread
+static int numFramesToSkip = 0;
+static int numFramesLeft = 0;
+static std::string captureFilePath = "";
+static std::atomic<long long> captureStart(0);
+static long long frameStart = 0;
+
+static ProfileTrack* getThreadTrack()
+{
+    if (threadTrack.track) return threadTrack.track;
+
+    std::lock_guard<std::mutex> lock(tracksMutex);
+
+    // Threads come and go, like the physics thread between screens, so tracks of exited ones are reused
+    // unless they hold zones of the capture that is being recorded
+    ProfileTrack* track = nullptr;
+    for (auto& t : tracks) {
+        if (!t->isThread || !t->isFree.load(std::memory_order_acquire)) continue;
+        if (Profiler::isRecording() && t->capture.load(std::memory_order_relaxed) == currentCapture.load()) continue;
+        track = t.get();
+        track->count.store(0, std::memory_order_relaxed);
+        track->capture.store(0, std::memory_order_relaxed);
+        track->isFree.store(false, std::memory_order_relaxed);
+        track->name.clear();
+        break;
+    }
+    if (!track) {
+        tracks.emplace_back(new ProfileTrack);
+        track = tracks.back().get();
+    }
+    track->id = nextTrackId++;
+
+    threadTrack.track = track;
+    return track;
+}
+
+bool Profiler::captureFrames(int numFrames, const std::string& filePath, int firstFrame /* = 0 */)
+{
+#if BENGINE_PROFILER_ENABLED
+    if (isCapturing() || numFrames <= 0) return false;
+
+    numFramesToSkip = (firstFrame > 0) ? firstFrame : 0;
+    numFramesLeft = numFrames;
+    captureFilePath = filePath;
+    printf("Capturing %d frames to %s\n", numFrames, filePath.c_str());
+    return true;
+#else
+    puts("Profiler zones are compiled out of this build, define BENGINE_PROFILER to record them");
+    return false;
+#endif
+}
+
+void Profiler::finishCapture()
+{
+    if (!isCapturing()) return;
+
+    bool wasRecording = isRecording();
+    m_isRecording = false;
+    numFramesLeft = 0;
+    if (wasRecording) write(captureFilePath);
+}
+
+bool Profiler::isCapturing()
+{
+    return numFramesLeft > 0;
+}
+
+void Profiler::beginFrame()
+{
+    long long time = now();
+
+    if (isRecording()) {
+        addZone("Frame", frameStart, time);
+        if (--numFramesLeft == 0) {
+            m_isRecording = false;
+            write(captureFilePath);
+        }
+    }
+    else if (numFramesLeft > 0) {
+        if (numFramesToSkip > 0) {
+            numFramesToSkip--;
+        }
+        else {
+            // A new capture makes every thread start its buffer over
+            currentCapture++;
+            captureStart = time;
+            m_isRecording = true;
+        }
+    }
+
+    frameStart = time;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    ProfileTrack* track = getThreadTrack();
+    std::lock_guard<std::mutex> lock(tracksMutex);
+    track->name = name;
+}
+
+long long Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void Profiler::addZone(const char* name, long long start, long long end)
+{
+    // Zones that end after the capture are left out
+    if (!isRecording()) return;
+
+    addZone(getThreadTrack(), name, start, end);
+}
+
+ProfileTrack* Profiler::addTrack(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(tracksMutex);
+    tracks.emplace_back(new ProfileTrack);
+    ProfileTrack* track = tracks.back().get();
+    track->isThread = false;
+    track->id = nextTrackId++;
+    track->name = name;
+    return track;
+}
+
+void Profiler::addZone(ProfileTrack* track, const char* name, long long start, long long end)
+{
+    if (!isRecording()) return;
+    if (start < captureStart.load(std::memory_order_relaxed)) return;
+
+    int capture = currentCapture.load(std::memory_order_relaxed);
+    if (track->capture.load(std::memory_order_relaxed) != capture) {
+        // First zone of this capture, the old ones have been written
+        if (track->events.empty()) track->events.resize(MAX_EVENTS_PER_TRACK);
+        track->numDropped.store(0, std::memory_order_relaxed);
+        track->count.store(0, std::memory_order_relaxed);
+        track->capture.store(capture, std::memory_order_release);
+    }
+
+    size_t count = track->count.load(std::memory_order_relaxed);
+    if (count == track->events.size()) {
+        track->numDropped.store(track->numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    track->events[count] = { name, start, end };
+    track->count.store(count + 1, std::memory_order_release);
+}
+
+bool Profiler::write(const std::string& filePath)
+{
+    FILE* file = fopen(filePath.c_str(), "w");
+    if (!file) {
+        printf("Failed to write profile to %s\n", filePath.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(tracksMutex);
+
+    // Complete events with times in microseconds from the start of the capture
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const int capture = currentCapture.load();
+    size_t numEvents = 0;
+    size_t numDropped = 0;
+    bool isFirst = true;
+    for (auto& t : tracks) {
+        if (t->capture.load(std::memory_order_acquire) != capture) continue;
+        const size_t count = t->count.load(std::memory_order_acquire);
+
+        const std::string name = t->name.empty() ? "Thread " + std::to_string(t->id) : t->name;
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                isFirst ? "" : ",\n", t->id, name.c_str());
+        isFirst = false;
+
+        for (size_t i = 0; i < count; i++) {
+            const ProfileEvent& e = t->events[i];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    e.name, t->id, (e.start - captureStart) * 0.001, (e.end - e.start) * 0.001);
+        }
+        numEvents += count;
+        numDropped += t->numDropped.load(std::memory_order_relaxed);
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Wrote %u zones to %s", (unsigned)numEvents, filePath.c_str());
+    if (numDropped > 0) printf(", %u more didn't fit", (unsigned)numDropped);
+    printf("\n");
+    return true;
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// Zones are recorded in debug builds, and in release builds with BENGINE_PROFILER defined.
+// BENGINE_NO_PROFILER takes them out of every build.
+#if !defined(BENGINE_NO_PROFILER) && (!defined(NDEBUG) || defined(BENGINE_PROFILER))
+#define BENGINE_PROFILER_ENABLED 1
+#else
+#define BENGINE_PROFILER_ENABLED 0
+#endif
+
+namespace Bengine {
+
+struct ProfileTrack;
+
+// Records where the time of a range of frames goes, as nested zones on every thread,
+// and writes it as Chrome trace_event JSON for chrome://tracing or Perfetto.
+// Each thread writes its zones to a buffer of its own, so recording takes no locks.
+class Profiler
+{
+public:
+    static const size_t MAX_EVENTS_PER_TRACK = 1 << 16; ///< Zones past this in one capture are dropped
+
+    // Records numFrames frames, starting firstFrame frames from now, and writes them to filePath.
+    // Returns false if the zones are compiled out or a capture is already going.
+    static bool captureFrames(int numFrames, const std::string& filePath, int firstFrame = 0);
+    // Stops the capture early and writes what was recorded so far
+    static void finishCapture();
+    static bool isCapturing();
+
+    // Call at the start of every frame on the main thread. Starts and ends captures.
+    static void beginFrame();
+
+    // Names the calling thread in traces
+    static void setThreadName(const std::string& name);
+
+    static bool isRecording() { return m_isRecording.load(std::memory_order_relaxed); }
+    // Nanoseconds on a steady clock
+    static long long now();
+    // name has to live until the capture is written, string literals do
+    static void addZone(const char* name, long long start, long long end);
+
+    // Tracks hold zones that weren't timed on a thread, like GPU passes. Only one thread at a time may add to a track.
+    static ProfileTrack* addTrack(const std::string& name);
+    // Zones that start before the capture are left out
+    static void addZone(ProfileTrack* track, const char* name, long long start, long long end);
+
+private:
+    static bool write(const std::string& filePath);
+
+    static std::atomic<bool> m_isRecording;
+};
+
+// Adds a zone from its construction to the end of its scope
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) :
+        m_name(name),
+        m_isRecording(Profiler::isRecording()),
+        m_start(m_isRecording ? Profiler::now() : 0)
+    {
+        // Empty
+    }
+
+    ~ProfileZone()
+    {
+        if (m_isRecording) Profiler::addZone(m_name, m_start, Profiler::now());
+    }
+
+private:
+    const char* m_name;
+    bool m_isRecording;
+    long long m_start;
+};
+
+}
+
+#if BENGINE_PROFILER_ENABLED
+#define BENGINE_PROFILE_CONCAT_(a, b) a##b
+#define BENGINE_PROFILE_CONCAT(a, b) BENGINE_PROFILE_CONCAT_(a, b)
+// Times the rest of the scope. name has to be a string literal.
+#define BENGINE_PROFILE_ZONE(name) Bengine::ProfileZone BENGINE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define BENGINE_PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Bengine {
+
+// Refers to one object in a SlotMap. Stays valid however the other objects move,
+// and stops being valid once its object is removed, even if the slot is reused.
+struct SlotHandle {
+    static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+    SlotHandle() {}
+    SlotHandle(uint32_t Slot, uint32_t Generation) : slot(Slot), generation(Generation) {}
+
+    bool isNull() const { return slot == NO_SLOT; }
+    bool operator==(const SlotHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+
+    uint32_t slot = NO_SLOT;
+    uint32_t generation = 0;
+};
+
+// Objects packed in a vector for iteration, found through handles that survive removals.
+// Inserting and removing are O(1). Removing moves the last object into the removed one's place,
+// so dense indices change but handles don't.
+template <typename T>
+class SlotMap
+{
+public:
+    SlotHandle insert(T value) {
+        uint32_t slot;
+        if (m_freeSlot != SlotHandle::NO_SLOT) {
+            slot = m_freeSlot;
+            m_freeSlot = m_slots[slot].index;
+        }
+        else {
+            slot = (uint32_t)m_slots.size();
+            m_slots.emplace_back();
+        }
+
+        m_slots[slot].index = (uint32_t)m_values.size();
+        m_values.push_back(std::move(value));
+        m_valueSlots.push_back(slot);
+        return SlotHandle(slot, m_slots[slot].generation);
+    }
+
+    // Returns false if handle was already removed
+    bool remove(SlotHandle handle) {
+        if (!contains(handle)) return false;
+
+        Slot& s = m_slots[handle.slot];
+        uint32_t last = (uint32_t)m_values.size() - 1;
+        if (s.index != last) {
+            m_values[s.index] = std::move(m_values[last]);
+            m_valueSlots[s.index] = m_valueSlots[last];
+            m_slots[m_valueSlots[s.index]].index = s.index;
+        }
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+
+        // Old handles to this slot no longer match
+        s.generation++;
+        s.index = m_freeSlot;
+        m_freeSlot = handle.slot;
+        return true;
+    }
+
+    // Removes everything, invalidating every handle
+    void clear() {
+        for (uint32_t slot : m_valueSlots) {
+            m_slots[slot].generation++;
+            m_slots[slot].index = m_freeSlot;
+            m_freeSlot = slot;
+        }
+        m_values.clear();
+        m_valueSlots.clear();
+    }
+
+    // Replaces the contents with values, in the same order
+    void assign(std::vector<T> values) {
+        clear();
+        m_values.reserve(values.size());
+        m_valueSlots.reserve(values.size());
+        for (auto& v : values) {
+            insert(std::move(v));
+        }
+    }
+
+    void reserve(size_t size) {
+        m_values.reserve(size);
+        m_valueSlots.reserve(size);
+        m_slots.reserve(size);
+    }
+
+    bool contains(SlotHandle handle) const {
+        if (handle.slot >= m_slots.size()) return false;
+
+        const Slot& s = m_slots[handle.slot];
+        return s.generation == handle.generation && s.index < m_valueSlots.size() && m_valueSlots[s.index] == handle.slot;
+    }
+
+    // Null if handle was removed
+    T* get(SlotHandle handle) { return contains(handle) ? &m_values[m_slots[handle.slot].index] : nullptr; }
+    const T* get(SlotHandle handle) const { return contains(handle) ? &m_values[m_slots[handle.slot].index] : nullptr; }
+
+    // Unchecked, handle must be valid
+    T& operator[](SlotHandle handle) { return m_values[m_slots[handle.slot].index]; }
+    const T& operator[](SlotHandle handle) const { return m_values[m_slots[handle.slot].index]; }
+
+    // Position of handle's object in the dense array, -1 if it was removed
+    int getIndex(SlotHandle handle) const { return contains(handle) ? (int)m_slots[handle.slot].index : -1; }
+    SlotHandle getHandle(size_t index) const {
+        uint32_t slot = m_valueSlots[index];
+        return SlotHandle(slot, m_slots[slot].generation);
+    }
+
+    // The objects in dense order, for code that works on plain vectors
+    const std::vector<T>& getValues() const { return m_values; }
+
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    typename std::vector<T>::iterator begin() { return m_values.begin(); }
+    typename std::vector<T>::iterator end() { return m_values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+private:
+    struct Slot {
+        uint32_t index = 0; ///< Into m_values, or the next free slot when free
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_valueSlots; ///< Slot of each value
+    std::vector<Slot> m_slots;
+    uint32_t m_freeSlot = SlotHandle::NO_SLOT; ///< Head of the free slot list
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <utility>
+
+namespace Bengine {
+
+// Passes the latest of a stream of snapshots from one thread to another without either one waiting
+// on the other. One copy is being written, one is ready and one is being read, so a published
+// snapshot never changes while it's read.
+template <typename T>
+class SnapshotBuffer
+{
+public:
+    // The copy to fill in before publish(). It holds an old snapshot, so overwrite all of it.
+    T& getWriteBuffer() { return m_buffers[m_write]; }
+
+    // Makes the write buffer the latest snapshot
+    void publish() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_write, m_ready);
+        m_hasNew = true;
+    }
+
+    // The latest published snapshot. Stays the same until the next call.
+    const T& getLatest() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasNew) {
+            std::swap(m_read, m_ready);
+            m_hasNew = false;
+        }
+        return m_buffers[m_read];
+    }
+
+private:
+    T m_buffers[3];
+    int m_write = 0;
+    int m_ready = 1;
+    int m_read = 2;
+    bool m_hasNew = false;
+    std::mutex m_mutex;
+};
+
+}
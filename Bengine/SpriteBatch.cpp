@@ -1,4 +1,5 @@
 #include "SpriteBatch.h"
+#include "Profiler.h"
 #include <algorithm>
 
 namespace Bengine {
@@ -92,18 +93,26 @@ void SpriteBatch::begin(GlyphSortType sortType /* GlyphSortType::TEXTURE */)
 	_renderBatches.clear();
 
 	_glyphs.clear();
+	_numQuadVertices = 0;
+	_quadBatches.clear();
 }
 
 
 void SpriteBatch::end()
 {
-	// Set up all pointers for fast sorting
-	_glyphPointers.resize(_glyphs.size());
-	for (unsigned i = 0; i < _glyphs.size(); i++) {
-		_glyphPointers[i] = &_glyphs[i];
-	}
+	BENGINE_PROFILE_ZONE("SpriteBatch::end");
+
+	{
+		BENGINE_PROFILE_ZONE("SpriteBatch::sortGlyphs");
+
+		// Set up all pointers for fast sorting
+		_glyphPointers.resize(_glyphs.size());
+		for (unsigned i = 0; i < _glyphs.size(); i++) {
+			_glyphPointers[i] = &_glyphs[i];
+		}
 
-	sortGlyphs();
+		sortGlyphs();
+	}
 	createRenderBatches();
 }
 
@@ -130,6 +139,25 @@ void SpriteBatch::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuin
     _glyphs.emplace_back(destRect, uvRect, texture, depth, color, angle);
 }
 
+Vertex* SpriteBatch::addQuads(GLuint texture, size_t numQuads)
+{
+	GLuint offset = (GLuint)_numQuadVertices;
+	GLuint numVertices = (GLuint)(numQuads * 6);
+	_numQuadVertices += numVertices;
+	// Only grows, so the vertices aren't cleared every frame just to be written again
+	if (_quadVertices.size() < _numQuadVertices) _quadVertices.resize(_numQuadVertices);
+
+	// Quads with the same texture as the ones before them are drawn together
+	if (!_quadBatches.empty() && _quadBatches.back().texture == texture) {
+		_quadBatches.back().numVertices += numVertices;
+	}
+	else {
+		_quadBatches.emplace_back(offset, numVertices, texture);
+	}
+
+	return _quadVertices.data() + offset;
+}
+
 void SpriteBatch::dispose()
 {
     if (_vao != 0) {
@@ -145,6 +173,8 @@ void SpriteBatch::dispose()
 
 void SpriteBatch::renderBatch()
 {
+	BENGINE_PROFILE_ZONE("SpriteBatch::renderBatch");
+
 	glBindVertexArray(_vao);
 
 	for (size_t i = 0; i < _renderBatches.size(); i++) {
@@ -159,10 +189,17 @@ void SpriteBatch::renderBatch()
 
 void SpriteBatch::createRenderBatches()
 {
-	std::vector<Vertex> vertices;
-	vertices.resize(_glyphPointers.size() * 6);
-
-	if (_glyphPointers.empty()) return;
+	BENGINE_PROFILE_ZONE("SpriteBatch::createRenderBatches");
+
+	// Reused between frames, a fresh buffer every frame costs more than filling it
+	std::vector<Vertex>& vertices = _vertices;
+	if (_glyphPointers.empty()) {
+		// Only quads, upload them as they are instead of copying them
+		_renderBatches = _quadBatches;
+		uploadVertices(_quadVertices.data(), _numQuadVertices);
+		return;
+	}
+	vertices.resize(_glyphPointers.size() * 6 + _numQuadVertices);
 
 	int offset = 0;
 	int cv = 0; // Current vertex
@@ -189,11 +226,31 @@ void SpriteBatch::createRenderBatches()
 		offset += 6;
 	}
 
+	// Quads go after the glyphs as they are
+	std::copy(_quadVertices.begin(), _quadVertices.begin() + _numQuadVertices, vertices.begin() + cv);
+	for (auto& batch : _quadBatches) {
+		if (!_renderBatches.empty() && _renderBatches.back().texture == batch.texture) {
+			_renderBatches.back().numVertices += batch.numVertices;
+		}
+		else {
+			_renderBatches.emplace_back(offset + batch.offset, batch.numVertices, batch.texture);
+		}
+	}
+
+	uploadVertices(vertices.data(), vertices.size());
+}
+
+void SpriteBatch::uploadVertices(const Vertex* vertices, size_t numVertices)
+{
+	if (numVertices == 0) return;
+
+	BENGINE_PROFILE_ZONE("SpriteBatch::uploadVertices");
+
 	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
 	// Orphan the buffer
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
 	// Upload the data
-	glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+	glBufferSubData(GL_ARRAY_BUFFER, 0, numVertices * sizeof(Vertex), vertices);
 	// Unbind the buffer
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
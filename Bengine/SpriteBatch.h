@@ -65,12 +65,17 @@ public:
 
     void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const ColorRGBA8& color, const glm::vec2& dir);
 
+    // Room for numQuads quads of 6 vertices, two triangles each, to fill in before end(). They skip the glyphs
+    // and their sorting, and are drawn after them in the order they were added. Valid until the next call.
+    Vertex* addQuads(GLuint texture, size_t numQuads);
+
     // Deletes vertex arrays and buffer
     void dispose();
 
 	void renderBatch();
 private:
 	void createRenderBatches();
+	void uploadVertices(const Vertex* vertices, size_t numVertices);
 	void createVertexArray();
 	void sortGlyphs();
 
@@ -84,6 +89,10 @@ private:
 	std::vector<Glyph *> _glyphPointers; ///< This is for sorting
 	std::vector<Glyph> _glyphs; ///< These are the actual glyphs
 	std::vector<RenderBatch> _renderBatches;
+	std::vector<Vertex> _vertices; ///< Vertices of the last end(), kept for their memory
+	std::vector<Vertex> _quadVertices; ///< From addQuads(), the first _numQuadVertices are this frame's
+	size_t _numQuadVertices = 0;
+	std::vector<RenderBatch> _quadBatches; ///< Offsets into _quadVertices
 };
 
 }
\ No newline at end of file
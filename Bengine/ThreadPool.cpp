@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+namespace Bengine {
+
+ThreadPool::ThreadPool()
+{
+    // Empty
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    dispose();
+}
+
+
+void ThreadPool::init(int numThreads /* = 0 */)
+{
+    if (m_isRunning) return;
+
+    if (numThreads <= 0) {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads <= 0) numThreads = 1;
+    }
+
+    m_isRunning = true;
+    for (int i = 0; i < numThreads; i++) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+
+void ThreadPool::dispose()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_isRunning) return;
+        m_isRunning = false;
+    }
+    m_taskAdded.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+void ThreadPool::addTask(std::function<void()> task)
+{
+    // Without workers the task just runs right away
+    if (!m_isRunning) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_taskAdded.notify_one();
+}
+
+
+void ThreadPool::waitForTasks()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksDone.wait(lock, [this]() { return m_tasks.empty() && m_numBusy == 0; });
+}
+
+
+void ThreadPool::workerLoop()
+{
+    Profiler::setThreadName("Worker");
+
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskAdded.wait(lock, [this]() { return !m_tasks.empty() || !m_isRunning; });
+
+            // Queued tasks are still finished when shutting down
+            if (m_tasks.empty()) return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+            m_numBusy++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_numBusy--;
+            if (m_tasks.empty() && m_numBusy == 0) m_tasksDone.notify_all();
+        }
+    }
+}
+
+}
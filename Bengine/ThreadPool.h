@@ -0,0 +1,44 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace Bengine {
+
+// A fixed set of worker threads that run tasks in the order they were added
+class ThreadPool
+{
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    // Starts the workers. 0 threads means one per hardware thread.
+    void init(int numThreads = 0);
+
+    // Finishes all queued tasks and joins the workers
+    void dispose();
+
+    void addTask(std::function<void()> task);
+
+    // Blocks until every task added so far has finished
+    void waitForTasks();
+
+    int getNumThreads() const { return (int)m_threads.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskAdded;
+    std::condition_variable m_tasksDone;
+    int m_numBusy = 0;
+    bool m_isRunning = false;
+};
+
+}
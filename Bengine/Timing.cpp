@@ -1,9 +1,21 @@
 #include "Timing.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Bengine {
 
-FPSLimiter::FPSLimiter() : _startTicks(0), _frames(0), _print(false)
+// Spin the last 2 ms of a wait until it's known how much SDL_Delay() oversleeps
+const double INITIAL_SPIN_TIME = 0.002;
+const double MIN_SPIN_TIME = 0.0005;
+// The spin time shrinks by this much per sleep, so one slow wake-up doesn't make every frame spin longer
+const double SPIN_DECAY = 0.99;
+
+FPSLimiter::FPSLimiter() : _print(false), _maxFPS(0.0f), _fps(0.0f), _frames(0), _startTicks(0)
 {
+	_frequency = SDL_GetPerformanceFrequency();
+	_spinTicks = (Uint64)(_frequency * INITIAL_SPIN_TIME);
+	std::fill(_frameTimes, _frameTimes + NUM_SAMPLES, 0.0f);
 }
 
 
@@ -16,6 +28,8 @@ void FPSLimiter::init(float maxFPS)
 void FPSLimiter::setMaxFPS(float maxFPS)
 {
 	_maxFPS = maxFPS;
+	// The new rate starts with the next frame
+	_deadline = 0;
 }
 
 
@@ -27,7 +41,7 @@ void FPSLimiter::printFPS(bool print)
 
 void FPSLimiter::begin()
 {
-	_startTicks = SDL_GetTicks();
+	_startTicks = SDL_GetPerformanceCounter();
 
 	if (_print) {
 		if (_frames++ == 10) {
@@ -40,61 +54,107 @@ void FPSLimiter::begin()
 
 float FPSLimiter::end()
 {
-	calculateFPS();
-
-	float frameTicks = SDL_GetTicks() - _startTicks;
-
 	// Limit the FPS to the maxFPS
-	if (_maxFPS >= 0) {
-		if (1000.0f / _maxFPS > frameTicks) {
-			SDL_Delay(1000.0f / _maxFPS - frameTicks);
+	if (_maxFPS > 0.0f) {
+		const Uint64 period = (Uint64)(_frequency / _maxFPS);
+		if (_deadline == 0) _deadline = _startTicks + period;
+
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now > _deadline) {
+			_stats.numMissedDeadlines++;
+			_stats.lastLateness = (float)toMilliseconds(now - _deadline);
+			_stats.worstLateness = std::max(_stats.worstLateness, _stats.lastLateness);
+			// Start over from here instead of rushing the next frames to catch up
+			_deadline = now;
 		}
+		else {
+			waitUntil(_deadline);
+		}
+		_deadline += period;
 	}
 
+	Uint64 end = SDL_GetPerformanceCounter();
+	if (_previousEnd != 0) addSample((float)toMilliseconds(end - _previousEnd));
+	_previousEnd = end;
+
+	calculateFPS();
+
 	return _fps;
 }
 
 
 float FPSLimiter::calculateFPS()
 {
-	static const int NUM_SAMPLES = 10;
-	static float frameTimes[NUM_SAMPLES];
-	static int currentFrame = 0;
-
-	static float previousTicks = SDL_GetTicks();
-	float currentTicks;
+	if (_stats.averageFrameTime > 0.0f) {
+		_fps = 1000.0f / _stats.averageFrameTime;
+	}
+	else {
+		_fps = 60.0f;
+	}
 
-	currentTicks = SDL_GetTicks();
+	return _fps;
+}
 
-	_frameTime = currentTicks - previousTicks;
-	frameTimes[currentFrame % NUM_SAMPLES] = _frameTime;
 
-	previousTicks = currentTicks;
+void FPSLimiter::resetStats()
+{
+	_stats = FramePacingStats();
+	_currentFrame = 0;
+}
 
-	int count;
 
-	currentFrame++;
-	if (currentFrame < NUM_SAMPLES) {
-		count = currentFrame;
+void FPSLimiter::waitUntil(Uint64 deadline)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	// Sleep while there's more than the spin time left
+	if (deadline > now + _spinTicks) {
+		Uint32 sleepTime = (Uint32)toMilliseconds(deadline - now - _spinTicks);
+		if (sleepTime > 0) {
+			Uint64 sleepStart = now;
+			SDL_Delay(sleepTime);
+			now = SDL_GetPerformanceCounter();
+
+			// Spin at least as long as this sleep overslept from now on
+			Uint64 slept = now - sleepStart;
+			Uint64 asked = sleepTime * _frequency / 1000;
+			Uint64 overslept = (slept > asked) ? slept - asked : 0;
+			Uint64 minSpin = (Uint64)(_frequency * MIN_SPIN_TIME);
+			_spinTicks = std::max(std::max((Uint64)(_spinTicks * SPIN_DECAY), overslept), minSpin);
+		}
 	}
-	else {
-		count = NUM_SAMPLES;
+
+	while (now < deadline) {
+		now = SDL_GetPerformanceCounter();
 	}
+}
+
+
+void FPSLimiter::addSample(float frameTime)
+{
+	_frameTimes[_currentFrame % NUM_SAMPLES] = frameTime;
+	_currentFrame++;
 
-	float frameTimeAverage = 0;
+	_stats.frameTime = frameTime;
+	_stats.numFrames++;
+
+	int count = (_currentFrame < NUM_SAMPLES) ? _currentFrame : NUM_SAMPLES;
+
+	float frameTimeAverage = 0.0f;
 	for (int i = 0; i < count; i++) {
-		frameTimeAverage += frameTimes[i];
+		frameTimeAverage += _frameTimes[i];
 	}
 	frameTimeAverage /= count;
 
-	if (frameTimeAverage > 0) {
-		_fps = 1000.0f / frameTimeAverage;
-	}
-	else {
-		_fps = 60.0f;
+	float variance = 0.0f;
+	for (int i = 0; i < count; i++) {
+		float difference = _frameTimes[i] - frameTimeAverage;
+		variance += difference * difference;
 	}
+	variance /= count;
 
-	return _fps;
+	_stats.averageFrameTime = frameTimeAverage;
+	_stats.jitter = std::sqrt(variance);
 }
 
-}
\ No newline at end of file
+}
@@ -5,29 +5,62 @@
 
 namespace Bengine {
 
+// Frame times of one FPSLimiter, in milliseconds
+struct FramePacingStats {
+	float frameTime = 0.0f; ///< From the end of the previous frame to the end of this one
+	float averageFrameTime = 0.0f; ///< Over the last FPSLimiter::NUM_SAMPLES frames
+	float jitter = 0.0f; ///< Standard deviation of the same frames
+	int numFrames = 0;
+	int numMissedDeadlines = 0; ///< Frames whose work ran past the time they should have ended
+	float lastLateness = 0.0f; ///< How late the last missed frame was
+	float worstLateness = 0.0f;
+};
+
+// Paces frames to a target rate on the performance counter. Each frame ends on a deadline one frame after
+// the previous one, so the rate doesn't drift. Waiting sleeps in whole milliseconds and spins the rest, since
+// SDL_Delay() often oversleeps by a millisecond or two. How much to spin is learned from how much it oversleeps.
 class FPSLimiter {
 public:
+	static const int NUM_SAMPLES = 64;
+
 	FPSLimiter();
 
 	void init(float maxFPS);
 
+	// 0 or less doesn't limit the frame rate
 	void setMaxFPS(float maxFPS);
 
 	void printFPS(bool print);
 
 	void begin();
 
-	// Will return the current FPS
+	// Waits for the end of the frame. Will return the current FPS
 	float end();
 
 	float calculateFPS();
+
+	const FramePacingStats& getStats() const { return _stats; }
+	void resetStats();
+
 private:
+	void waitUntil(Uint64 deadline);
+	void addSample(float frameTime);
+	double toMilliseconds(Uint64 ticks) const { return ticks * 1000.0 / _frequency; }
+
 	bool _print;
 	float _maxFPS;
 	float _fps;
 	int _frames;
-	float _frameTime;
-	unsigned int _startTicks;
+	Uint64 _startTicks; ///< When begin() was called
+
+	Uint64 _frequency; ///< Performance counter ticks per second
+	Uint64 _deadline = 0; ///< When the current frame should end, 0 before the first frame
+	Uint64 _previousEnd = 0;
+	Uint64 _spinTicks; ///< Waits shorter than this are spun instead of slept
+
+	float _frameTimes[NUM_SAMPLES];
+	int _currentFrame = 0;
+	FramePacingStats _stats;
 };
 
-}
\ No newline at end of file
+}
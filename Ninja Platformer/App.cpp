@@ -22,6 +22,7 @@ void App::addScreens()
 {
     m_mainMenuScreen = std::make_unique<MainMenuScreen>(&m_window);
     m_gameplayScreen = std::make_unique<GameplayScreen>(&m_window);
+    m_gameplayScreen->setLevelPath(m_levelPath);
     m_levelEditorScreen = std::make_unique<LevelEditorScreen>(&m_window);
 
     m_screenList->addScreen(m_mainMenuScreen.get());
@@ -16,7 +16,12 @@ public:
     virtual void addScreens() override;
     virtual void onExit() override;
 
+    // Level the gameplay screen plays, set before run()
+    void setLevelPath(const std::string& filePath) { m_levelPath = filePath; }
+
 private:
+    std::string m_levelPath = "";
+
     std::unique_ptr<MainMenuScreen> m_mainMenuScreen = nullptr;
     std::unique_ptr<GameplayScreen> m_gameplayScreen = nullptr;
     std::unique_ptr<LevelEditorScreen> m_levelEditorScreen = nullptr;
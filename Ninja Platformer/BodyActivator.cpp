@@ -0,0 +1,73 @@
+#include "BodyActivator.h"
+
+#include <algorithm>
+
+void BodyActivator::init(float radius, float margin, size_t bodiesPerUpdate /*= 256*/)
+{
+    m_radius = radius;
+    m_margin = margin;
+    m_bodiesPerUpdate = bodiesPerUpdate;
+    clear();
+}
+
+void BodyActivator::addBody(b2Body* body)
+{
+    TrackedBody t;
+    t.body = body;
+    t.linearVelocity = body->GetLinearVelocity();
+    t.angularVelocity = body->GetAngularVelocity();
+    t.wasAwake = body->IsAwake();
+    m_bodies.push_back(t);
+}
+
+void BodyActivator::clear()
+{
+    m_bodies.clear();
+    m_nextBody = 0;
+}
+
+void BodyActivator::update(const glm::vec2& center)
+{
+    if (m_bodies.empty()) return;
+
+    const b2Vec2 c(center.x, center.y);
+    const float deactivateDistSq = m_radius * m_radius;
+    const float activateDistSq = (m_radius - m_margin) * (m_radius - m_margin);
+
+    // Look at a slice of the bodies each frame. The margin covers how far things move
+    // before their turn comes around again.
+    size_t count = std::min(m_bodiesPerUpdate, m_bodies.size());
+    for (size_t i = 0; i < count; i++) {
+        if (m_nextBody >= m_bodies.size()) m_nextBody = 0;
+        TrackedBody& t = m_bodies[m_nextBody++];
+        b2Body* body = t.body;
+
+        float distSq = b2DistanceSquared(body->GetPosition(), c);
+
+        // The body's actual state is checked rather than remembered, since restarting a level
+        // can turn everything back on
+        if (body->IsActive()) {
+            if (distSq > deactivateDistSq) {
+                t.linearVelocity = body->GetLinearVelocity();
+                t.angularVelocity = body->GetAngularVelocity();
+                t.wasAwake = body->IsAwake();
+                body->SetActive(false);
+            }
+        }
+        else if (distSq < activateDistSq) {
+            body->SetActive(true);
+            body->SetLinearVelocity(t.linearVelocity);
+            body->SetAngularVelocity(t.angularVelocity);
+            body->SetAwake(t.wasAwake);
+        }
+    }
+}
+
+size_t BodyActivator::getNumInactive() const
+{
+    size_t numInactive = 0;
+    for (auto& t : m_bodies) {
+        if (!t.body->IsActive()) numInactive++;
+    }
+    return numInactive;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Turns off bodies that are far from the action, so the cost of a physics step depends on
+// what's around the player rather than on the size of the level.
+// Inactive bodies have no broad-phase proxies or contacts and are skipped by the solver.
+class BodyActivator
+{
+public:
+    // Bodies further than radius are deactivated, and come back once they're within radius - margin.
+    // bodiesPerUpdate is how many bodies update() looks at, so huge levels are spread over several frames.
+    void init(float radius, float margin, size_t bodiesPerUpdate = 256);
+
+    // Only added bodies are ever deactivated
+    void addBody(b2Body* body);
+    void clear();
+
+    void update(const glm::vec2& center);
+
+    size_t getNumBodies() const { return m_bodies.size(); }
+    size_t getNumInactive() const;
+
+private:
+    struct TrackedBody {
+        b2Body* body;
+        // Saved when the body is deactivated
+        b2Vec2 linearVelocity;
+        float angularVelocity;
+        bool wasAwake;
+    };
+
+    std::vector<TrackedBody> m_bodies;
+    size_t m_nextBody = 0; ///< Where the next update() continues from
+    float m_radius = 0.0f;
+    float m_margin = 0.0f;
+    size_t m_bodiesPerUpdate = 0;
+};
@@ -28,6 +28,8 @@ void Box::init(b2World* world,
     m_uvRect = uvRect;
     m_isDynamic = isDynamic;
 
+    m_fixedRotation = fixedRotation;
+
     // Make the body
     b2BodyDef bodyDef;
     if (isDynamic) {
@@ -37,14 +39,59 @@ void Box::init(b2World* world,
         bodyDef.type = b2_staticBody;
     }
 
-    bodyDef.type = b2_dynamicBody;
     bodyDef.position.Set(position.x, position.y);
     bodyDef.fixedRotation = fixedRotation;
     bodyDef.angle = angle;
     m_body = world->CreateBody(&bodyDef);
 
+    createFixture();
+}
+
+void Box::destroy(b2World* world)
+{
+    if (m_body) world->DestroyBody(m_body);
+}
+
+void Box::detachBody(b2World* world)
+{
+    m_position = getPosition();
+    m_angle = getAngle();
+
+    world->DestroyBody(m_body);
+    m_body = nullptr;
+    m_fixture = nullptr;
+}
+
+void Box::setTransform(const glm::vec2& position, float angle)
+{
+    if (m_body) {
+        m_body->SetTransform(b2Vec2(position.x, position.y), angle);
+    }
+    else {
+        m_position = position;
+        m_angle = angle;
+    }
+}
+
+void Box::setDimensions(const glm::vec2& dimensions)
+{
+    m_dimensions = dimensions;
+    if (!m_body) return;
+
+    m_body->DestroyFixture(m_fixture);
+    createFixture();
+}
+
+void Box::setIsDynamic(bool isDynamic)
+{
+    m_isDynamic = isDynamic;
+    if (m_body) m_body->SetType(isDynamic ? b2_dynamicBody : b2_staticBody);
+}
+
+void Box::createFixture()
+{
     b2PolygonShape boxShape;
-    boxShape.SetAsBox(dimensions.x / 2, dimensions.y / 2);
+    boxShape.SetAsBox(m_dimensions.x / 2, m_dimensions.y / 2);
 
     // Make the fixture
     b2FixtureDef fixtureDef;
@@ -54,16 +101,13 @@ void Box::init(b2World* world,
     m_fixture = m_body->CreateFixture(&fixtureDef);
 }
 
-void Box::destroy(b2World* world)
-{
-    world->DestroyBody(m_body);
-}
-
 void Box::draw(Bengine::SpriteBatch& spriteBatch)
 {
+    glm::vec2 position = getPosition();
+
     glm::vec4 destRect(
-        m_body->GetPosition().x - m_dimensions.x / 2.0f,
-        m_body->GetPosition().y - m_dimensions.y / 2.0f,
+        position.x - m_dimensions.x / 2.0f,
+        position.y - m_dimensions.y / 2.0f,
         m_dimensions
     );
 
@@ -73,6 +117,6 @@ void Box::draw(Bengine::SpriteBatch& spriteBatch)
         m_texture.id,
         0.0f,
         m_color,
-        m_body->GetAngle()
+        getAngle()
     );
 }
@@ -26,26 +26,38 @@ public:
 
     void destroy(b2World* world);
 
-    void draw(Bengine::SpriteBatch& spriteBatch);
+    // Destroys the body but keeps the box around for drawing, for when another body collides in its place
+    void detachBody(b2World* world);
+
+    // Edit the box in place. Moving and rotating keep the body, resizing only replaces the fixture.
+    void setTransform(const glm::vec2& position, float angle);
+    void setDimensions(const glm::vec2& dimensions);
+    void setIsDynamic(bool isDynamic);
+    void setTexture(const Bengine::GLTexture& texture) { m_texture = texture; }
+    void setColor(const Bengine::ColorRGBA8& color) { m_color = color; }
+    void setUvRect(const glm::vec4& uvRect) { m_uvRect = uvRect; }
 
-    // Checks if a point is inside the box
-    bool pointInBox(float x, float y) const { return m_fixture->TestPoint(b2Vec2(x, y)); }
+    void draw(Bengine::SpriteBatch& spriteBatch);
 
     b2Body*                    getBody()          const { return m_body; }
     b2Fixture*                 getFixture()       const { return m_fixture; }
     const Bengine::GLTexture&  getTexture()       const { return m_texture; }
     glm::vec4                  getUvRect()        const { return m_uvRect; }
-    glm::vec2                  getPosition()      const { return glm::vec2(m_body->GetPosition().x, m_body->GetPosition().y); }
+    glm::vec2                  getPosition()      const { return m_body ? glm::vec2(m_body->GetPosition().x, m_body->GetPosition().y) : m_position; }
     const glm::vec2&           getDimensions()    const { return m_dimensions; }
-    float                      getAngle()         const { return m_body->GetAngle(); }
+    float                      getAngle()         const { return m_body ? m_body->GetAngle() : m_angle; }
     const Bengine::ColorRGBA8& getColor()         const { return m_color; }
     const bool&                getFixedRotation() const { return m_fixedRotation; }
     const bool&                getIsDynamic()     const { return m_isDynamic; }
 private:
+    void createFixture();
+
     glm::vec4 m_uvRect;
     b2Body* m_body = nullptr;
     b2Fixture* m_fixture = nullptr;
     glm::vec2 m_dimensions;
+    glm::vec2 m_position; ///< Only used once the body is detached
+    float m_angle = 0.0f; ///< Only used once the body is detached
     Bengine::ColorRGBA8 m_color;
     Bengine::GLTexture m_texture;
     bool m_fixedRotation = false;
@@ -0,0 +1,131 @@
+#include "BoxRenderStore.h"
+
+#include <cmath>
+
+void BoxRenderStore::build(const std::vector<Box>& boxes)
+{
+    clear();
+
+    const size_t numBoxes = boxes.size();
+    m_x.resize(numBoxes);
+    m_y.resize(numBoxes);
+    m_angle.resize(numBoxes);
+    m_dimensions.resize(numBoxes);
+    m_cullRadius.resize(numBoxes);
+    m_uvRects.resize(numBoxes);
+    m_colors.resize(numBoxes);
+    m_textures.resize(numBoxes);
+
+    for (size_t i = 0; i < numBoxes; i++) {
+        const Box& box = boxes[i];
+        glm::vec2 position = box.getPosition();
+        m_x[i] = position.x;
+        m_y[i] = position.y;
+        m_angle[i] = box.getAngle();
+
+        m_dimensions[i] = box.getDimensions();
+        m_cullRadius[i] = glm::length(box.getDimensions()) / 2.0f;
+        m_uvRects[i] = box.getUvRect();
+        m_colors[i] = box.getColor();
+        m_textures[i] = box.getTexture().id;
+
+        if (box.getBody() && box.getIsDynamic()) {
+            m_movingBodies.push_back(box.getBody());
+            m_movingIndices.push_back(i);
+        }
+    }
+
+    m_previousX = m_x;
+    m_previousY = m_y;
+    m_previousAngle = m_angle;
+
+    for (size_t i : m_movingIndices) {
+        m_stepX.push_back(m_x[i]);
+        m_stepY.push_back(m_y[i]);
+        m_stepAngle.push_back(m_angle[i]);
+    }
+}
+
+void BoxRenderStore::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_angle.clear();
+    m_previousX.clear();
+    m_previousY.clear();
+    m_previousAngle.clear();
+    m_dimensions.clear();
+    m_cullRadius.clear();
+    m_uvRects.clear();
+    m_colors.clear();
+    m_textures.clear();
+    m_movingBodies.clear();
+    m_movingIndices.clear();
+    m_stepX.clear();
+    m_stepY.clear();
+    m_stepAngle.clear();
+}
+
+void BoxRenderStore::syncTransforms(BoxTransforms& transforms)
+{
+    const size_t numMoving = m_movingBodies.size();
+    transforms.previousX.assign(m_stepX.begin(), m_stepX.end());
+    transforms.previousY.assign(m_stepY.begin(), m_stepY.end());
+    transforms.previousAngle.assign(m_stepAngle.begin(), m_stepAngle.end());
+
+    for (size_t k = 0; k < numMoving; k++) {
+        const b2Transform& transform = m_movingBodies[k]->GetTransform();
+        m_stepX[k] = transform.p.x;
+        m_stepY[k] = transform.p.y;
+        m_stepAngle[k] = m_movingBodies[k]->GetAngle();
+    }
+
+    transforms.x.assign(m_stepX.begin(), m_stepX.end());
+    transforms.y.assign(m_stepY.begin(), m_stepY.end());
+    transforms.angle.assign(m_stepAngle.begin(), m_stepAngle.end());
+}
+
+void BoxRenderStore::setTransforms(const BoxTransforms& transforms)
+{
+    // A snapshot from before the last build() doesn't fit
+    if (transforms.x.size() != m_movingIndices.size()) return;
+
+    for (size_t k = 0; k < m_movingIndices.size(); k++) {
+        const size_t i = m_movingIndices[k];
+        m_x[i] = transforms.x[k];
+        m_y[i] = transforms.y[k];
+        m_angle[i] = transforms.angle[k];
+        m_previousX[i] = transforms.previousX[k];
+        m_previousY[i] = transforms.previousY[k];
+        m_previousAngle[i] = transforms.previousAngle[k];
+    }
+}
+
+void BoxRenderStore::draw(Bengine::SpriteBatch& spriteBatch, float alpha, const glm::vec2& viewCenter, const glm::vec2& viewDims) const
+{
+    const glm::vec2 halfView = viewDims / 2.0f;
+
+    for (size_t i = 0; i < m_x.size(); i++) {
+        float x = m_previousX[i] + (m_x[i] - m_previousX[i]) * alpha;
+        float y = m_previousY[i] + (m_y[i] - m_previousY[i]) * alpha;
+
+        // Cull with a circle around the box, so the angle doesn't matter
+        const float r = m_cullRadius[i];
+        if (std::fabs(x - viewCenter.x) > halfView.x + r || std::fabs(y - viewCenter.y) > halfView.y + r) continue;
+
+        float angle = m_previousAngle[i] + (m_angle[i] - m_previousAngle[i]) * alpha;
+        const glm::vec2& dims = m_dimensions[i];
+        glm::vec4 destRect(x - dims.x / 2.0f, y - dims.y / 2.0f, dims.x, dims.y);
+
+        spriteBatch.draw(destRect, m_uvRects[i], m_textures[i], 0.0f, m_colors[i], angle);
+    }
+}
+
+void BoxRenderStore::drawDebug(Bengine::DebugRenderer& debugRenderer, const Bengine::ColorRGBA8& color) const
+{
+    for (size_t i = 0; i < m_x.size(); i++) {
+        const glm::vec2& dims = m_dimensions[i];
+        glm::vec4 destRect(m_x[i] - dims.x / 2.0f, m_y[i] - dims.y / 2.0f, dims.x, dims.y);
+        debugRenderer.drawBox(destRect, color, m_angle[i]);
+    }
+}
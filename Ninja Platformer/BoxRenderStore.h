@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <Bengine/SpriteBatch.h>
+#include <Bengine/DebugRenderer.h>
+#include <vector>
+
+#include "Box.h"
+
+// Transforms of the boxes that can move after a physics step, and before it for interpolation
+struct BoxTransforms {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> angle;
+    std::vector<float> previousX;
+    std::vector<float> previousY;
+    std::vector<float> previousAngle;
+};
+
+// Everything needed to draw the level's boxes, in flat arrays indexed by box.
+// Transforms are copied out of Box2D once per step, so drawing and culling never touch the bodies.
+class BoxRenderStore
+{
+public:
+    // Copies the render data and transforms of boxes. Call again when boxes are added, removed or moved outside of a step.
+    void build(const std::vector<Box>& boxes);
+    void clear();
+
+    // Copies the transforms of the boxes that can move into transforms. Call after every physics step.
+    // Only touches the bodies and the step-side copies, so it can run on the physics thread.
+    void syncTransforms(BoxTransforms& transforms);
+    // Takes the transforms to draw with from a syncTransforms() result
+    void setTransforms(const BoxTransforms& transforms);
+
+    // Draws the boxes that overlap the view, alpha of the way from their previous transforms to their current ones
+    void draw(Bengine::SpriteBatch& spriteBatch, float alpha, const glm::vec2& viewCenter, const glm::vec2& viewDims) const;
+    void drawDebug(Bengine::DebugRenderer& debugRenderer, const Bengine::ColorRGBA8& color) const;
+
+    size_t getNumBoxes() const { return m_x.size(); }
+
+private:
+    // Transforms
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_angle;
+    std::vector<float> m_previousX;
+    std::vector<float> m_previousY;
+    std::vector<float> m_previousAngle;
+
+    // Render data
+    std::vector<glm::vec2> m_dimensions;
+    std::vector<float> m_cullRadius; ///< Half the diagonal, covers any rotation
+    std::vector<glm::vec4> m_uvRects;
+    std::vector<Bengine::ColorRGBA8> m_colors;
+    std::vector<GLuint> m_textures;
+
+    // Only dynamic boxes move, the rest are copied once in build()
+    std::vector<b2Body*> m_movingBodies;
+    std::vector<size_t> m_movingIndices;
+
+    // Moving box transforms as of the last syncTransforms(), only used by it
+    std::vector<float> m_stepX;
+    std::vector<float> m_stepY;
+    std::vector<float> m_stepAngle;
+};
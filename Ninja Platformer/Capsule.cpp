@@ -43,6 +43,16 @@ void Capsule::init(b2World* world,
     // Top circle
     circleShape.m_p.Set(0.0f, (m_dimensions.y - dimensions.x) / 2.0f);
     m_fixtures[2] = m_body->CreateFixture(&circleDef);
+
+    // Foot sensor, a thin box across the bottom. Narrower than the capsule so walls don't touch it,
+    // and only a little below it so the ground counts just before the feet land on it.
+    b2PolygonShape footShape;
+    footShape.SetAsBox(dimensions.x * 0.4f, 0.05f, b2Vec2(0.0f, -dimensions.y / 2.0f + 0.03f), 0.0f);
+
+    b2FixtureDef footDef;
+    footDef.shape = &footShape;
+    footDef.isSensor = true;
+    m_footSensor = m_body->CreateFixture(&footDef);
 }
 
 void Capsule::destroy(b2World* world)
@@ -51,17 +61,22 @@ void Capsule::destroy(b2World* world)
 }
 
 void Capsule::drawDebug(Bengine::DebugRenderer& debugRenderer)
+{
+    drawDebug(debugRenderer, glm::vec2(m_body->GetPosition().x, m_body->GetPosition().y), m_body->GetAngle());
+}
+
+void Capsule::drawDebug(Bengine::DebugRenderer& debugRenderer, const glm::vec2& position, float angle)
 {
     Bengine::ColorRGBA8 color(255, 255, 255, 255);
 
     // Draw box
     glm::vec4 destRect(
-        m_body->GetPosition().x - m_dimensions.x / 2.0f,
-        m_body->GetPosition().y - (m_dimensions.y - m_dimensions.x) / 2.0f,
+        position.x - m_dimensions.x / 2.0f,
+        position.y - (m_dimensions.y - m_dimensions.x) / 2.0f,
         m_dimensions.x, m_dimensions.y - m_dimensions.x
     );
 
-    debugRenderer.drawBox(destRect, color, m_body->GetAngle());
+    debugRenderer.drawBox(destRect, color, angle);
 
     // Draw circles
     debugRenderer.drawCircle(
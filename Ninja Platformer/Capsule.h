@@ -19,13 +19,17 @@ public:
     void destroy(b2World* world);
 
     void drawDebug(Bengine::DebugRenderer& debugRenderer);
+    // Draws the outline at position and angle instead of where the body is
+    void drawDebug(Bengine::DebugRenderer& debugRenderer, const glm::vec2& position, float angle);
 
     b2Body* getBody() const { return m_body; }
     b2Fixture* getFixture(int index) const { return m_fixtures[index]; }
+    b2Fixture* getFootSensor() const { return m_footSensor; }
     const glm::vec2& getDimensions() const { return m_dimensions; }
 
 private:
     b2Body* m_body = nullptr;
     b2Fixture* m_fixtures[3];
+    b2Fixture* m_footSensor = nullptr; ///< Overlaps whatever the capsule stands on
     glm::vec2 m_dimensions;
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "CharacterAnimator.h"
+
+#include <cmath>
+
+int CharacterAnimator::add()
+{
+    m_directions.push_back(1);
+    m_isPunching.push_back(0);
+    m_moveStates.push_back(CharacterMoveState::STANDING);
+    m_animationTimes.push_back(0.0f);
+    m_tileIndices.push_back(0);
+
+    return (int)m_tileIndices.size() - 1;
+}
+
+void CharacterAnimator::clear()
+{
+    m_directions.clear();
+    m_isPunching.clear();
+    m_moveStates.clear();
+    m_animationTimes.clear();
+    m_tileIndices.clear();
+}
+
+void CharacterAnimator::setInput(int index, int moveInput, bool punch)
+{
+    if (moveInput != 0) m_directions[index] = (moveInput > 0) ? 1 : -1;
+    if (punch) m_isPunching[index] = 1;
+}
+
+void CharacterAnimator::update(const CharacterStates& states)
+{
+    // States can lag a step behind a new character, it keeps its tile until they catch up
+    const size_t numCharacters = (states.size() < size()) ? states.size() : size();
+
+    for (size_t i = 0; i < numCharacters; i++) {
+        const float velocityX = states.velocityX[i];
+        const float velocityY = states.velocityY[i];
+        const int direction = m_directions[i];
+        CharacterMoveState& moveState = m_moveStates[i];
+        float& animationTime = m_animationTimes[i];
+
+        int tileIndex;
+        int numTiles;
+        float animationSpeed = 0.1f;
+
+        if (states.onGround[i]) {
+            if (m_isPunching[i]) {
+                // Punching on ground
+                numTiles = 4;
+                tileIndex = 1;
+                if (moveState != CharacterMoveState::PUNCHING) {
+                    moveState = CharacterMoveState::PUNCHING;
+                    animationTime = 0.0f;
+                }
+            }
+            else if (std::abs(velocityX) > 1.0f && ((velocityX > 0 && direction > 0) || (velocityX < 0 && direction < 0))) {
+                // Running
+                numTiles = 6;
+                tileIndex = 10;
+                animationSpeed = std::abs(velocityX) * 0.005f;
+                if (moveState != CharacterMoveState::RUNNING) {
+                    moveState = CharacterMoveState::RUNNING;
+                    animationTime = 0.0f;
+                }
+            }
+            else {
+                // Standing
+                numTiles = 1;
+                tileIndex = 0;
+                moveState = CharacterMoveState::STANDING;
+            }
+        }
+        else {
+            // In the air
+            if (m_isPunching[i]) {
+                // Kicking in the air
+                animationSpeed *= 0.25f;
+                numTiles = 1;
+                tileIndex = 18;
+                if (moveState != CharacterMoveState::PUNCHING) {
+                    moveState = CharacterMoveState::PUNCHING;
+                    animationTime = 0.0f;
+                }
+            }
+            else if (std::abs(velocityX) > 19.5f) {
+                // Going fast in the air
+                numTiles = 1;
+                tileIndex = 10;
+                moveState = CharacterMoveState::IN_AIR;
+            }
+            else if (velocityY <= 0) {
+                // Falling
+                numTiles = 1;
+                tileIndex = 17;
+                moveState = CharacterMoveState::IN_AIR;
+            }
+            else {
+                // Rising
+                numTiles = 1;
+                tileIndex = 16;
+                moveState = CharacterMoveState::IN_AIR;
+            }
+        }
+
+        // Increment animation time
+        animationTime += animationSpeed;
+
+        // Check for punch end
+        if (animationTime > numTiles) m_isPunching[i] = 0;
+
+        // Apply animation
+        m_tileIndices[i] = tileIndex + (int)animationTime % numTiles;
+    }
+}
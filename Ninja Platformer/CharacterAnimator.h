@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CharacterController.h"
+
+enum class CharacterMoveState {STANDING, RUNNING, PUNCHING, IN_AIR};
+
+// Picks the ninja sprite sheet tile of every character once a frame, from the latest physics states,
+// so drawing only has to look the tile up. Runs on the main thread, next to input and drawing.
+class CharacterAnimator
+{
+public:
+    // Returns the index of the new character, which should match its CharacterController index
+    int add();
+    void clear();
+
+    // Faces the way of a non-zero moveInput, and starts a punch if punch is set
+    void setInput(int index, int moveInput, bool punch);
+
+    // Advances the animations of all characters by one frame
+    void update(const CharacterStates& states);
+
+    int getTileIndex(int index) const { return m_tileIndices[index]; }
+    int getDirection(int index) const { return m_directions[index]; }
+    size_t size() const { return m_tileIndices.size(); }
+
+private:
+    std::vector<int8_t> m_directions; ///< 1 or -1
+    std::vector<uint8_t> m_isPunching;
+    std::vector<CharacterMoveState> m_moveStates;
+    std::vector<float> m_animationTimes;
+    std::vector<int> m_tileIndices;
+};
@@ -0,0 +1,137 @@
+#include "CharacterController.h"
+
+#include <cmath>
+
+const float MOVE_FORCE = 325.0f;
+const float MAX_SPEED = 20.0f;
+const float JUMP_IMPULSE = 60.0f;
+
+int CharacterController::add(const Capsule& capsule)
+{
+    b2Body* body = capsule.getBody();
+    m_bodies.push_back(body);
+    m_footSensors.push_back(capsule.getFootSensor());
+    m_moveInput.push_back(0);
+    m_jumpRequested.push_back(0);
+    m_numGroundContacts.push_back(0);
+    m_previousX.push_back(body->GetPosition().x);
+    m_previousY.push_back(body->GetPosition().y);
+    m_previousAngle.push_back(body->GetAngle());
+
+    m_velocityX.push_back(0.0f);
+    m_velocityY.push_back(0.0f);
+    m_inverseMass.push_back(0.0f);
+    m_forceX.push_back(0.0f);
+
+    return (int)m_bodies.size() - 1;
+}
+
+void CharacterController::clear()
+{
+    m_bodies.clear();
+    m_footSensors.clear();
+    m_moveInput.clear();
+    m_jumpRequested.clear();
+    m_numGroundContacts.clear();
+    m_previousX.clear();
+    m_previousY.clear();
+    m_previousAngle.clear();
+    m_velocityX.clear();
+    m_velocityY.clear();
+    m_inverseMass.clear();
+    m_forceX.clear();
+}
+
+void CharacterController::subscribeContacts(Bengine::ContactEventQueue& contactEvents)
+{
+    for (size_t i = 0; i < m_footSensors.size(); i++) {
+        contactEvents.subscribe(m_footSensors[i], [this, i](const Bengine::ContactEvent& e) {
+            m_numGroundContacts[i] += (e.type == Bengine::ContactEventType::BEGIN) ? 1 : -1;
+        });
+    }
+}
+
+void CharacterController::setInput(int index, int moveInput, bool jump)
+{
+    m_moveInput[index] = (int8_t)moveInput;
+    // Kept until the next physics step, which may be a frame or two away at low step rates
+    if (jump) m_jumpRequested[index] = 1;
+}
+
+void CharacterController::fixedUpdate(float timeStep)
+{
+    const size_t numCharacters = m_bodies.size();
+
+    for (size_t i = 0; i < numCharacters; i++) {
+        const b2Body* body = m_bodies[i];
+        m_velocityX[i] = body->GetLinearVelocity().x;
+        m_velocityY[i] = body->GetLinearVelocity().y;
+        float mass = body->GetMass();
+        m_inverseMass[i] = (mass > 0.0f) ? 1.0f / mass : 0.0f;
+    }
+
+    // Tuned as 1% per step at 144 steps per second
+    const float damping = powf(0.99f, timeStep * 144.0f);
+
+    // No branches or body calls in here, so it vectorizes
+    for (size_t i = 0; i < numCharacters; i++) {
+        float move = (float)m_moveInput[i];
+        // Forces are cleared after every step, so they're applied again each step
+        m_forceX[i] = MOVE_FORCE * move;
+
+        // Only brake when there's no input
+        float vx = (move != 0.0f) ? m_velocityX[i] : m_velocityX[i] * damping;
+        vx = std::fmin(std::fmax(vx, -MAX_SPEED), MAX_SPEED);
+        m_velocityX[i] = vx;
+
+        // A jump pressed in the air is dropped, not saved for landing
+        bool jump = (m_numGroundContacts[i] > 0) && m_jumpRequested[i];
+        m_velocityY[i] += jump ? JUMP_IMPULSE * m_inverseMass[i] : 0.0f;
+        m_jumpRequested[i] = 0;
+    }
+
+    for (size_t i = 0; i < numCharacters; i++) {
+        b2Body* body = m_bodies[i];
+        if (m_forceX[i] != 0.0f) {
+            body->ApplyForceToCenter(b2Vec2(m_forceX[i], 0.0f), true);
+        }
+        const b2Vec2& velocity = body->GetLinearVelocity();
+        if (velocity.x != m_velocityX[i] || velocity.y != m_velocityY[i]) {
+            body->SetLinearVelocity(b2Vec2(m_velocityX[i], m_velocityY[i]));
+        }
+    }
+}
+
+void CharacterController::storePreviousTransforms()
+{
+    for (size_t i = 0; i < m_bodies.size(); i++) {
+        const b2Body* body = m_bodies[i];
+        m_previousX[i] = body->GetPosition().x;
+        m_previousY[i] = body->GetPosition().y;
+        m_previousAngle[i] = body->GetAngle();
+    }
+}
+
+void CharacterController::getStates(CharacterStates& states) const
+{
+    const size_t numCharacters = m_bodies.size();
+    states.x.resize(numCharacters);
+    states.y.resize(numCharacters);
+    states.angle.resize(numCharacters);
+    states.velocityX.resize(numCharacters);
+    states.velocityY.resize(numCharacters);
+    states.onGround.resize(numCharacters);
+    states.previousX.assign(m_previousX.begin(), m_previousX.end());
+    states.previousY.assign(m_previousY.begin(), m_previousY.end());
+    states.previousAngle.assign(m_previousAngle.begin(), m_previousAngle.end());
+
+    for (size_t i = 0; i < numCharacters; i++) {
+        const b2Body* body = m_bodies[i];
+        states.x[i] = body->GetPosition().x;
+        states.y[i] = body->GetPosition().y;
+        states.angle[i] = body->GetAngle();
+        states.velocityX[i] = body->GetLinearVelocity().x;
+        states.velocityY[i] = body->GetLinearVelocity().y;
+        states.onGround[i] = (m_numGroundContacts[i] > 0);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <Bengine/ContactEventQueue.h>
+#include <cstdint>
+#include <vector>
+
+#include "Capsule.h"
+
+// What drawing and animation need from the characters after a physics step, indexed by character
+struct CharacterStates {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> angle;
+    std::vector<float> previousX;
+    std::vector<float> previousY;
+    std::vector<float> previousAngle;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<uint8_t> onGround;
+
+    size_t size() const { return x.size(); }
+};
+
+// Runs, jumps and brakes every capsule character, the player and anyone else, in one pass over flat arrays.
+// Only the first and last loops of fixedUpdate() touch the bodies, the movement itself never leaves the arrays.
+class CharacterController
+{
+public:
+    // Returns the index of the new character. Indices stay the same until clear().
+    int add(const Capsule& capsule);
+    void clear();
+
+    // Counts what every character's foot sensor touches. Call after adding, with the queue listening to the world.
+    void subscribeContacts(Bengine::ContactEventQueue& contactEvents);
+
+    // Sets the movement fixedUpdate() applies. A jump is kept until the next step.
+    void setInput(int index, int moveInput, bool jump);
+
+    // Applies the input to the bodies, once per physics step
+    void fixedUpdate(float timeStep);
+
+    // Remembers where the bodies are before a physics step, for interpolated drawing
+    void storePreviousTransforms();
+    void getStates(CharacterStates& states) const;
+
+    bool isOnGround(int index) const { return m_numGroundContacts[index] > 0; }
+    b2Body* getBody(int index) const { return m_bodies[index]; }
+    size_t size() const { return m_bodies.size(); }
+
+private:
+    std::vector<b2Body*> m_bodies;
+    std::vector<b2Fixture*> m_footSensors;
+
+    // Input
+    std::vector<int8_t> m_moveInput; ///< -1, 0 or 1
+    std::vector<uint8_t> m_jumpRequested;
+
+    std::vector<int> m_numGroundContacts; ///< Solid fixtures touching the foot sensor
+    std::vector<float> m_previousX;
+    std::vector<float> m_previousY;
+    std::vector<float> m_previousAngle;
+
+    // Filled from the bodies at the start of fixedUpdate(), only used by it
+    std::vector<float> m_velocityX;
+    std::vector<float> m_velocityY;
+    std::vector<float> m_inverseMass;
+    std::vector<float> m_forceX;
+};
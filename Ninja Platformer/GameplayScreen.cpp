@@ -2,6 +2,8 @@
 #include "SDL/SDL.h"
 #include "Light.h"
 #include "FlashLight.h"
+#include "LevelReaderWriter.h"
+#include "LevelCooker.h"
 #include <Bengine/IMainGame.h>
 #include <Bengine/ResourceManager.h>
 #include <Bengine/Vertex.h>
@@ -9,6 +11,7 @@
 #include <random>
 #include <ctime>
 #include "ScreenIndices.h"
+#include "GameplaySettings.h"
 
 GameplayScreen::GameplayScreen(Bengine::Window* window) :
     m_window(window)
@@ -47,45 +50,9 @@ void GameplayScreen::onEntry()
 
     releaseKeys();
 
-    // Same gravity as earth
-    b2Vec2 gravity(0.0f, -34.0f);
-    // Make the world
-    m_world = std::make_unique<b2World>(gravity);
-
-    // Make the ground
-    b2BodyDef groundBodyDef;
-    // Create ground body definition
-    groundBodyDef.position.Set(0.0f, -26.86f);
-    // Create the ground body
-    b2Body* groundBody = m_world->CreateBody(&groundBodyDef);
-    // Make the ground fixture
-    b2PolygonShape groundBox;
-    groundBox.SetAsBox(50.0f, 10.0f);
-    groundBody->CreateFixture(&groundBox, 0.0f);
-
-    // Load the texture
-    m_texture = Bengine::ResourceManager::getTexture("Assets/bricks_top.png");
+    m_physicsQuality.init(PHYSICS_BUDGET, MIN_PHYSICS_QUALITY, MAX_PHYSICS_QUALITY, Bengine::PhysicsQuality());
 
-    // Make a bunch of boxes
-    std::mt19937 randGenerator((unsigned int)time(nullptr));
-    std::uniform_real_distribution<float> xPos(-10.0f, 10.0f);
-    std::uniform_real_distribution<float> yPos(-10.0f, 15.0f);
-    std::uniform_real_distribution<float> size(1.0f, 2.5f);
-    std::uniform_int_distribution<int> colr(0, 255);
-
-    const int NUM_BOXES = 15;
-
-    for (size_t i = 0; i < NUM_BOXES; i++) {
-        Bengine::ColorRGBA8 randColor;
-        randColor.r = colr(randGenerator);
-        randColor.g = colr(randGenerator);
-        randColor.b = colr(randGenerator);
-        randColor.a = 50;
-        Box newBox;
-
-        newBox.init(m_world.get(), glm::vec2(xPos(randGenerator), yPos(randGenerator)), glm::vec2(size(randGenerator), size(randGenerator)), m_texture, randColor, true);
-        m_boxes.push_back(newBox);
-    }
+    initLevel();
 
     // Initialize sprite batch
     m_spriteBatch.init();
@@ -112,13 +79,16 @@ void GameplayScreen::onEntry()
 	m_flashLightProgram.addAttribute("vertexUV");
 	m_flashLightProgram.linkShaders();
 
+    // Time the render passes on the GPU
+    m_gpuTimer.init();
+    m_texturePass = m_gpuTimer.addPass("Texture pass");
+    m_debugPass = m_gpuTimer.addPass("Debug pass");
+    m_flashLightPass = m_gpuTimer.addPass("Flashlight pass");
+
     // Init camera
     m_camera.init(m_window->getScreenWidth(), m_window->getScreenHeight());
     m_camera.setScale(32.0f); ///< Scale out because the world is in meters
 
-    // Init player
-    m_player.init(m_world.get(), glm::vec2(0.0f, 30.0f), glm::vec2(2.0f), glm::vec2(1.0f, 1.8f), Bengine::ColorRGBA8(255, 255, 255, 50));
-
     // Init UI
     //initUI();
 }
@@ -126,25 +96,177 @@ void GameplayScreen::onEntry()
 void GameplayScreen::onExit()
 {
     m_debugRenderer.dispose();
+    m_gpuTimer.dispose();
+
+    m_levelStart.clear();
+    m_bodyActivator.clear();
+    m_contactEvents.clear();
+    m_characters.clear();
+    m_characterAnimation.clear();
+    m_boxRender.clear();
+    m_boxes.clear();
+    m_world.reset();
+}
+
+void GameplayScreen::initLevel()
+{
+    m_boxes.clear();
+
+    // Same gravity as earth
+    b2Vec2 gravity(0.0f, -34.0f);
+    // Make the world
+    m_world = std::make_unique<b2World>(gravity);
+
+    m_contactEvents.clear();
+    m_world->SetContactListener(&m_contactEvents);
+
+    // Load the texture
+    m_texture = Bengine::ResourceManager::getTexture("Assets/bricks_top.png");
+
+    // Gameplay doesn't draw level lights yet
+    std::vector<Box> boxes;
+    std::vector<Light> lights;
+    if (!m_levelPath.empty() && LevelReaderWriter::loadFromText(m_levelPath, m_world.get(), m_player, boxes, lights)) {
+        size_t numMerged = LevelCooker::mergeStaticBoxes(m_world.get(), boxes);
+        std::cout << "Merged " << numMerged << " static boxes into chain shapes\n";
+        m_boxes.assign(std::move(boxes));
+    }
+    else {
+        // Make the ground
+        b2BodyDef groundBodyDef;
+        // Create ground body definition
+        groundBodyDef.position.Set(0.0f, -26.86f);
+        // Create the ground body
+        b2Body* groundBody = m_world->CreateBody(&groundBodyDef);
+        // Make the ground fixture
+        b2PolygonShape groundBox;
+        groundBox.SetAsBox(50.0f, 10.0f);
+        groundBody->CreateFixture(&groundBox, 0.0f);
+
+        // Make a bunch of boxes
+        std::mt19937 randGenerator((unsigned int)time(nullptr));
+        std::uniform_real_distribution<float> xPos(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> yPos(-10.0f, 15.0f);
+        std::uniform_real_distribution<float> size(1.0f, 2.5f);
+        std::uniform_int_distribution<int> colr(0, 255);
+
+        const int NUM_BOXES = 15;
+
+        for (size_t i = 0; i < NUM_BOXES; i++) {
+            Bengine::ColorRGBA8 randColor;
+            randColor.r = colr(randGenerator);
+            randColor.g = colr(randGenerator);
+            randColor.b = colr(randGenerator);
+            randColor.a = 50;
+            Box newBox;
+
+            newBox.init(m_world.get(), glm::vec2(xPos(randGenerator), yPos(randGenerator)), glm::vec2(size(randGenerator), size(randGenerator)), m_texture, randColor, true);
+            m_boxes.insert(newBox);
+        }
+
+        // Init player
+        m_player.init(m_world.get(), glm::vec2(0.0f, 30.0f), glm::vec2(2.0f), glm::vec2(1.0f, 1.8f), Bengine::ColorRGBA8(255, 255, 255, 50));
+    }
+
+    // The player is the only character so far
+    m_characters.clear();
+    m_characterAnimation.clear();
+    m_player.setCharacter(m_characters.add(m_player.getCapsule()));
+    m_characterAnimation.add();
+    m_characters.subscribeContacts(m_contactEvents);
+
+    m_bodyActivator.init(ACTIVATION_RADIUS, ACTIVATION_MARGIN);
+    for (auto& box : m_boxes) {
+        if (box.getIsDynamic()) m_bodyActivator.addBody(box.getBody());
+    }
+
+    m_boxRender.build(m_boxes.getValues());
+    publishSnapshot();
+
+    // Remember how the level started so restarting doesn't have to load it again
+    m_levelStart.capture(m_world.get(), m_characters, m_boxes);
+}
+
+void GameplayScreen::restartLevel()
+{
+    // Keep the physics thread out of the world until it's back in place
+    std::unique_lock<std::mutex> lock = m_game->lockFixedSteps();
+
+    if (m_levelStart.restore(m_world.get(), m_characters, m_boxes)) {
+        // The characters' contact counts went back with it, so the end events from the restore are stale
+        m_contactEvents.clearEvents();
+        m_boxRender.build(m_boxes.getValues());
+        publishSnapshot();
+        return;
+    }
+
+    // Bodies were added or removed since the start, so build the level from scratch
+    initLevel();
 }
 
 void GameplayScreen::update()
 {
     m_camera.update();
     checkInput();
-    m_player.update(m_game->inputManager);
+    // The physics thread may be stepping, so the movement goes to it as a command
+    PlayerInput input = Player::readInput(m_game->inputManager);
+    int character = m_player.getCharacter();
+    m_characterAnimation.setInput(character, input.move, input.punch);
+    m_physicsCommands.push([this, character, input]() {
+        m_characters.setInput(character, input.move, input.jump);
+    });
+
+    m_physicsCommands.push([this]() {
+        m_physicsQuality.endFrame();
+    });
+}
+
+void GameplayScreen::fixedUpdate(float timeStep)
+{
+    m_physicsCommands.execute();
 
-    // Update the physics simulation
-    m_world->Step(1.0f / 144.0f, 6, 2);
+    m_bodyActivator.update(m_player.getPosition());
+
+    // Keep the pre-step transform around so draw() can blend between steps
+    m_characters.storePreviousTransforms();
+
+    m_characters.fixedUpdate(timeStep);
+
+    // Update the physics simulation, with as many iterations as the budget allows
+    m_physicsQuality.step(m_world.get(), timeStep);
+
+    m_contactEvents.dispatch();
+    publishSnapshot();
+}
+
+void GameplayScreen::publishSnapshot()
+{
+    GameplaySnapshot& snapshot = m_snapshots.getWriteBuffer();
+    m_characters.getStates(snapshot.characters);
+    // Also keeps the pre-step box transforms for blending
+    m_boxRender.syncTransforms(snapshot.boxes);
+    snapshot.physics = m_physicsQuality.getStats();
+    m_snapshots.publish();
 }
 
 void GameplayScreen::draw()
 {
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); LINES :D
 
+    // Pick up the pass times the GPU has finished since last frame
+    m_gpuTimer.update();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // The world may be stepping on the physics thread, so draw from the last step it published
+    const GameplaySnapshot& snapshot = m_snapshots.getLatest();
+    m_boxRender.setTransforms(snapshot.boxes);
+    m_characterAnimation.update(snapshot.characters);
+    m_game->setPhysicsStats(snapshot.physics);
+    const glm::vec2 playerPosition(snapshot.characters.x[m_player.getCharacter()], snapshot.characters.y[m_player.getCharacter()]);
     
+    m_gpuTimer.beginPass(m_texturePass);
     m_textureProgram.use();
     m_spriteBatch.begin();
 
@@ -171,8 +293,8 @@ void GameplayScreen::draw()
 		// Set flashlight direction
 		glm::vec2 direction = glm::normalize(
 			glm::vec2(
-				m_player.getPosition().x + m_window->getScreenWidth() / 32.0f / 2.0f,
-				m_player.getPosition().y + m_window->getScreenHeight() / 32.0f / 2.0f
+				playerPosition.x + m_window->getScreenWidth() / 32.0f / 2.0f,
+				playerPosition.y + m_window->getScreenHeight() / 32.0f / 2.0f
 			)
 			- glm::vec2(960, 1080) / 32.0f
 		);
@@ -193,39 +315,31 @@ void GameplayScreen::draw()
 	GLint colorOnUniform = m_textureProgram.getUniformLocation("flashLightOn");
 	glUniform1i(colorOnUniform, m_lights);
 		
-    // Draw all the boxes
-    for (auto& box : m_boxes) {
-        box.draw(m_spriteBatch);
-    }
+    // Draw everything between the last two physics steps
+    float alpha = m_game->getInterpolationAlpha();
+
+    // Draw the boxes that are on screen
+    glm::vec2 viewDims = glm::vec2(m_window->getScreenWidth(), m_window->getScreenHeight()) / m_camera.getScale();
+    m_boxRender.draw(m_spriteBatch, alpha, m_camera.getPosition(), viewDims);
 
     // Draw the player
-    m_player.draw(m_spriteBatch);
+    m_player.draw(m_spriteBatch, snapshot.characters, m_characterAnimation, alpha);
 
     m_spriteBatch.end();
     m_spriteBatch.renderBatch();
 
     m_textureProgram.unuse();
+    m_gpuTimer.endPass();
 
     // Debug rendering
     if (m_renderDebug) {
+        Bengine::GpuPassScope debugPass(m_gpuTimer, m_debugPass);
         Bengine::ColorRGBA8 color(255, 255, 255, 255);
 
         // Draw collision boxes for boxes
-        for (auto& box : m_boxes) {
-            glm::vec4 destRect(
-                box.getBody()->GetPosition().x - box.getDimensions().x / 2.0f,
-                box.getBody()->GetPosition().y - box.getDimensions().y / 2.0f,
-                box.getDimensions().x, box.getDimensions().y
-            );
-
-            m_debugRenderer.drawBox(
-                destRect,
-                color,
-                box.getBody()->GetAngle()
-            );
-        }
+        m_boxRender.drawDebug(m_debugRenderer, color);
 
-        m_player.drawDebug(m_debugRenderer);
+        m_player.drawDebug(m_debugRenderer, snapshot.characters);
         
         m_debugRenderer.end();
         m_debugRenderer.render(projectionMatrix, 2.0f);
@@ -239,7 +353,7 @@ void GameplayScreen::draw()
     if (m_lights) {
         Light playerLight;
         playerLight.color = Bengine::ColorRGBA8(50, 50, 255, 128);
-        playerLight.position = m_player.getPosition();
+        playerLight.position = playerPosition;
         playerLight.size = 25.0f;
 
         Light mouseLight;
@@ -269,6 +383,7 @@ void GameplayScreen::draw()
 
 	// Render Flashlight
 	if (m_lights) {
+		Bengine::GpuPassScope flashLightPass(m_gpuTimer, m_flashLightPass);
 		FlashLight flashLight;
 		flashLight.color = m_flashLightColor;
 		flashLight.position = glm::vec2(960, 1080);
@@ -281,8 +396,8 @@ void GameplayScreen::draw()
 		// Set flashlight direction
 		flashLight.direction = glm::normalize(
 			glm::vec2 (
-				m_player.getPosition().x + m_window->getScreenWidth() / 32.0f / 2.0f,
-				m_player.getPosition().y + m_window->getScreenHeight() / 32.0f / 2.0f
+				playerPosition.x + m_window->getScreenWidth() / 32.0f / 2.0f,
+				playerPosition.y + m_window->getScreenHeight() / 32.0f / 2.0f
 			)
 			- flashLight.position / 32.0f
 		);
@@ -332,6 +447,7 @@ void GameplayScreen::releaseKeys()
     m_game->inputManager.releaseKey(SDLK_LSHIFT);
     m_game->inputManager.releaseKey(SDLK_LCTRL);
     m_game->inputManager.releaseKey(SDLK_SPACE);
+    m_game->inputManager.releaseKey(SDLK_r);
 }
 
 void GameplayScreen::initUI()
@@ -381,6 +497,7 @@ void GameplayScreen::checkInput()
 
     if (m_game->inputManager.isKeyPressed(SDLK_LCTRL)) m_renderDebug = !m_renderDebug;
     if (m_game->inputManager.isKeyPressed(SDLK_LSHIFT)) m_lights = !m_lights;
+    if (m_game->inputManager.isKeyPressed(SDLK_r)) restartLevel();
 }
 
 void GameplayScreen::onExitClicked()
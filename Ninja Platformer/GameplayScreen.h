@@ -10,11 +10,32 @@
 #include <Bengine/GLTexture.h>
 #include <Bengine/SpriteFont.h>
 #include <Bengine/DebugRenderer.h>
+#include <Bengine/GpuTimer.h>
+#include <Bengine/ContactEventQueue.h>
+#include <Bengine/SlotMap.h>
+#include <Bengine/PhysicsQualityController.h>
+#include <Bengine/CommandQueue.h>
+#include <Bengine/SnapshotBuffer.h>
 #include <memory>
 #include "Box.h"
 #include "Player.h"
+#include "CharacterController.h"
+#include "CharacterAnimator.h"
+#include "LevelSnapshot.h"
+#include "BodyActivator.h"
+#include "BoxRenderStore.h"
 #include <vector>
 
+// What draw() needs from a physics step
+struct GameplaySnapshot {
+    CharacterStates characters;
+    BoxTransforms boxes;
+    Bengine::PhysicsStats physics; ///< Passed on to the frame stats
+};
+
+// The world is only touched by fixedUpdate(), or by the main thread while it holds the fixed step lock,
+// so fixedUpdate() can run on the physics thread. Input reaches it through m_physicsCommands
+// and draw() reads the latest of m_snapshots.
 class GameplayScreen : public Bengine::IGameScreen
 {
 public:
@@ -35,11 +56,22 @@ public:
 
     virtual void update() override;
 
+    virtual void fixedUpdate(float timeStep) override;
+
+    virtual bool supportsPhysicsThread() const override { return true; }
+
     virtual void draw() override;
 
     void releaseKeys();
 
+    // Level to play. An empty path plays the demo level.
+    void setLevelPath(const std::string& filePath) { m_levelPath = filePath; }
+
 private:
+    void initLevel();
+    void restartLevel();
+    // Copies what draw() needs out of the world
+    void publishSnapshot();
     void initUI();
     void checkInput();
 
@@ -54,13 +86,29 @@ private:
     Bengine::GLTexture m_texture;
     Bengine::Window* m_window;
     Bengine::DebugRenderer m_debugRenderer;
+    Bengine::GpuTimer m_gpuTimer;
+    int m_texturePass = 0;
+    int m_debugPass = 0;
+    int m_flashLightPass = 0;
     Bengine::GUI m_gui;
 	Bengine::ColorRGBA8 m_flashLightColor = Bengine::ColorRGBA8(255, 0, 255, 200);
 
     bool m_renderDebug = false;
     bool m_lights = false;
 
+    std::string m_levelPath = "";
+    LevelSnapshot m_levelStart;
+    Bengine::ContactEventQueue m_contactEvents;
+    BodyActivator m_bodyActivator;
+    Bengine::PhysicsQualityController m_physicsQuality;
+
     Player m_player;
-    std::vector<Box> m_boxes;
+    CharacterController m_characters;
+    CharacterAnimator m_characterAnimation; ///< Only used on the main thread
+    Bengine::SlotMap<Box> m_boxes;
+    BoxRenderStore m_boxRender;
+
+    Bengine::CommandQueue m_physicsCommands; ///< Run at the start of the next fixedUpdate()
+    Bengine::SnapshotBuffer<GameplaySnapshot> m_snapshots;
     std::unique_ptr<b2World> m_world;
 };
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Bengine/PhysicsQualityController.h>
+
+// Shared by GameplayScreen and the soak test, so the soak test simulates levels the way the game does
+
+// Dynamic boxes further than this from the player stop simulating
+const float ACTIVATION_RADIUS = 80.0f;
+const float ACTIVATION_MARGIN = 10.0f;
+
+// Milliseconds per frame the physics may take before it gets fewer iterations
+const float PHYSICS_BUDGET = 2.0f;
+const Bengine::PhysicsQuality MIN_PHYSICS_QUALITY(3, 1, 1);
+const Bengine::PhysicsQuality MAX_PHYSICS_QUALITY(8, 3, 2);
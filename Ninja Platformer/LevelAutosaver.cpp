@@ -0,0 +1,277 @@
+#include "LevelAutosaver.h"
+
+#include <Bengine/IOManager.h>
+#include <SDL/SDL.h>
+#include <algorithm>
+#include <fstream>
+
+const std::string AUTOSAVE_DIRECTORY = "Autosave";
+const unsigned int AUTOSAVE_INTERVAL = 10000; ///< Milliseconds between journal writes
+const size_t MIN_COMPACT_EDITS = 256; ///< Journals shorter than this are never compacted
+
+// Returns 0 for missing files, which is also the size of a level that has no file
+static size_t getFileSize(const std::string& filePath)
+{
+    if (filePath.empty()) return 0;
+
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (file.fail()) return 0;
+
+    return (size_t)file.tellg();
+}
+
+LevelAutosaver::LevelAutosaver() :
+    m_saveResult(SaveResult::NONE),
+    m_numSavedEdits(0)
+{
+    // Empty
+}
+
+LevelAutosaver::~LevelAutosaver()
+{
+    dispose();
+}
+
+void LevelAutosaver::init()
+{
+    Bengine::IOManager::makeDirectory(AUTOSAVE_DIRECTORY.c_str());
+
+    // One worker, so the writes happen in the order they were queued
+    m_worker.init(1);
+    m_lastFlushTime = SDL_GetTicks();
+}
+
+void LevelAutosaver::dispose()
+{
+    flushEdits();
+    m_worker.dispose();
+}
+
+void LevelAutosaver::setLevel(const std::string& levelName, const std::string& basePath, bool continueJournal, size_t numJournalEdits)
+{
+    // Edits made so far belong to the old level
+    flushEdits();
+    m_numJournalEdits = continueJournal ? numJournalEdits : 0;
+
+    m_worker.addTask([this, levelName, basePath, continueJournal]() {
+        m_levelName = levelName;
+        m_basePath = basePath;
+        m_journalStarted = continueJournal;
+    });
+}
+
+void LevelAutosaver::setPlayer(const Player& player)
+{
+    LevelEdit edit;
+    edit.type = LevelEditType::SET_PLAYER;
+    LevelReaderWriter::makePlayerData(player, edit.player);
+    addEdit(edit);
+}
+
+void LevelAutosaver::setBox(size_t index, const Box& box)
+{
+    LevelEdit edit;
+    edit.type = LevelEditType::SET_BOX;
+    edit.index = index;
+    LevelReaderWriter::makeBoxData(box, edit.box);
+    edit.texturePath = box.getTexture().filePath;
+    addEdit(edit);
+}
+
+void LevelAutosaver::removeBox(size_t index)
+{
+    LevelEdit edit;
+    edit.type = LevelEditType::SWAP_REMOVE_BOX;
+    edit.index = index;
+    addEdit(edit);
+}
+
+void LevelAutosaver::setLight(size_t index, const Light& light)
+{
+    LevelEdit edit;
+    edit.type = LevelEditType::SET_LIGHT;
+    edit.index = index;
+    edit.light = light;
+    addEdit(edit);
+}
+
+void LevelAutosaver::removeLight(size_t index)
+{
+    LevelEdit edit;
+    edit.type = LevelEditType::SWAP_REMOVE_LIGHT;
+    edit.index = index;
+    addEdit(edit);
+}
+
+void LevelAutosaver::update(const Player* player, const std::vector<Box>& boxes, const std::vector<Light>& lights)
+{
+    takeSavedEdits();
+
+    unsigned int time = SDL_GetTicks();
+    if (time - m_lastFlushTime < AUTOSAVE_INTERVAL) return;
+    m_lastFlushTime = time;
+
+    flushEdits();
+
+    // Once the journal is longer than the level itself, replaying it costs more than loading a snapshot.
+    // The level format always has a player, so there's nothing to snapshot until one is placed.
+    if (player && m_numJournalEdits > std::max(MIN_COMPACT_EDITS, boxes.size() + lights.size())) {
+        compact(*player, boxes, lights);
+    }
+}
+
+void LevelAutosaver::save(const std::string& filePath, const std::string& levelName, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights)
+{
+    // The journal has to be complete in case the save fails. The single worker writes it before saving.
+    flushEdits();
+    size_t numJournalEdits = m_numJournalEdits;
+
+    LevelData level;
+    LevelReaderWriter::makeLevelData(&player, boxes, lights, level);
+
+    m_worker.addTask([this, filePath, levelName, level, numJournalEdits]() {
+        if (!LevelReaderWriter::saveAsText(filePath, level)) {
+            // Keep journaling to the old level
+            m_saveResult = SaveResult::FAILURE;
+            return;
+        }
+
+        // The saved file has every edit in it, so the ones in the old journal aren't needed anymore
+        m_numSavedEdits = numJournalEdits;
+
+        // Old journals of either name would replay edits that are already in the file
+        removeAutosaveFiles(m_levelName);
+        removeAutosaveFiles(levelName);
+
+        m_levelName = levelName;
+        m_basePath = filePath;
+        m_journalStarted = false;
+        m_saveResult = SaveResult::SUCCESS;
+    });
+}
+
+SaveResult LevelAutosaver::getSaveResult()
+{
+    takeSavedEdits();
+    return m_saveResult.exchange(SaveResult::NONE);
+}
+
+bool LevelAutosaver::recover(const std::string& levelName, LevelData& level, std::string& basePath, size_t& numJournalEdits)
+{
+    std::string journalPath = getJournalPath(levelName);
+    if (getFileSize(journalPath) == 0) return false;
+
+    size_t baseSize;
+    std::vector<LevelEdit> edits;
+    if (!LevelReaderWriter::loadJournal(journalPath, basePath, baseSize, edits)) {
+        return false;
+    }
+
+    // The edits only make sense on top of the exact file they were made to
+    if (getFileSize(basePath) != baseSize) {
+        printf("Level %s was changed after its journal was written, not recovering it\n", levelName.c_str());
+        return false;
+    }
+
+    LevelData recovered;
+    if (!basePath.empty() && !LevelReaderWriter::loadFromText(basePath, recovered)) {
+        return false;
+    }
+
+    for (auto& e : edits) {
+        if (!LevelReaderWriter::applyEdit(e, recovered)) {
+            puts("Journal doesn't match its level, not recovering it");
+            return false;
+        }
+    }
+
+    printf("Recovered %d unsaved edits to level %s\n", (int)edits.size(), levelName.c_str());
+    level = std::move(recovered);
+    numJournalEdits = edits.size();
+    return true;
+}
+
+void LevelAutosaver::addEdit(const LevelEdit& edit)
+{
+    // Dragging something around changes it every frame, only the last state is worth keeping
+    if (!m_pendingEdits.empty() && (edit.type == LevelEditType::SET_PLAYER || edit.type == LevelEditType::SET_BOX || edit.type == LevelEditType::SET_LIGHT)) {
+        LevelEdit& last = m_pendingEdits.back();
+        if (last.type == edit.type && last.index == edit.index) {
+            last = edit;
+            return;
+        }
+    }
+
+    m_pendingEdits.push_back(edit);
+}
+
+void LevelAutosaver::flushEdits()
+{
+    if (m_pendingEdits.empty()) return;
+
+    m_numJournalEdits += m_pendingEdits.size();
+
+    std::vector<LevelEdit> edits;
+    edits.swap(m_pendingEdits);
+
+    m_worker.addTask([this, edits]() {
+        std::string journalPath = getJournalPath(m_levelName);
+
+        if (!m_journalStarted) {
+            m_journalStarted = LevelReaderWriter::startJournal(journalPath, m_basePath, getFileSize(m_basePath));
+            if (!m_journalStarted) return;
+        }
+
+        if (!LevelReaderWriter::appendToJournal(journalPath, edits)) {
+            puts("Failed to write the level journal!");
+        }
+    });
+}
+
+void LevelAutosaver::takeSavedEdits()
+{
+    // Edits made while the save ran went to the new journal and still count
+    size_t numSavedEdits = m_numSavedEdits.exchange(0);
+    m_numJournalEdits -= std::min(numSavedEdits, m_numJournalEdits);
+}
+
+void LevelAutosaver::compact(const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights)
+{
+    m_numJournalEdits = 0;
+
+    // Copying the level is cheap, turning it into text is left to the worker
+    LevelData level;
+    LevelReaderWriter::makeLevelData(&player, boxes, lights, level);
+
+    m_worker.addTask([this, level]() {
+        // Alternate between two snapshots so the one the current journal is based on is never overwritten.
+        // If we crash halfway through, the old journal still replays onto the old snapshot.
+        std::string snapshotPath = getSnapshotPath(m_levelName, 0);
+        if (snapshotPath == m_basePath) snapshotPath = getSnapshotPath(m_levelName, 1);
+
+        if (!LevelReaderWriter::saveAsText(snapshotPath, level)) return;
+
+        std::string journalPath = getJournalPath(m_levelName);
+        if (LevelReaderWriter::startJournal(journalPath, snapshotPath, getFileSize(snapshotPath))) {
+            m_basePath = snapshotPath;
+            m_journalStarted = true;
+        }
+    });
+}
+
+std::string LevelAutosaver::getJournalPath(const std::string& levelName)
+{
+    return AUTOSAVE_DIRECTORY + "/" + levelName + ".journal";
+}
+
+std::string LevelAutosaver::getSnapshotPath(const std::string& levelName, int index)
+{
+    return AUTOSAVE_DIRECTORY + "/" + levelName + ".snapshot" + std::to_string(index);
+}
+
+void LevelAutosaver::removeAutosaveFiles(const std::string& levelName)
+{
+    Bengine::IOManager::removeFile(getJournalPath(levelName).c_str());
+    Bengine::IOManager::removeFile(getSnapshotPath(levelName, 0).c_str());
+    Bengine::IOManager::removeFile(getSnapshotPath(levelName, 1).c_str());
+}
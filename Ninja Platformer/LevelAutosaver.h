@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Bengine/ThreadPool.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "LevelReaderWriter.h"
+
+const std::string UNTITLED_LEVEL = "untitled";
+
+enum class SaveResult {
+    NONE,
+    SUCCESS,
+    FAILURE
+};
+
+// Keeps an append-only journal of editor changes so a crash loses at most a few seconds of work.
+// Edits are batched on the main thread and all file writes happen on a worker thread.
+// Every so often the journal is compacted into a full level snapshot so it doesn't grow forever.
+class LevelAutosaver
+{
+public:
+    LevelAutosaver();
+    ~LevelAutosaver();
+
+    void init();
+    // Writes out the remaining edits and stops the worker
+    void dispose();
+
+    // Switches the journal to another level. basePath is the level file the edits apply to, "" for an empty level.
+    // If continueJournal is true the existing journal, holding numJournalEdits edits, is appended to.
+    void setLevel(const std::string& levelName, const std::string& basePath, bool continueJournal = false, size_t numJournalEdits = 0);
+
+    void setPlayer(const Player& player);
+    void setBox(size_t index, const Box& box); ///< index == number of boxes adds a box
+    void removeBox(size_t index); ///< The last box takes its place, like in a SlotMap
+    void setLight(size_t index, const Light& light); ///< index == number of lights adds a light
+    void removeLight(size_t index); ///< The last light takes its place
+
+    // Sends batched edits to the worker and compacts the journal when it gets long. Call once per frame.
+    void update(const Player* player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
+
+    // Saves the level in the background. The result is reported by getSaveResult().
+    void save(const std::string& filePath, const std::string& levelName, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
+    // Returns the result of the last finished save once, NONE otherwise
+    SaveResult getSaveResult();
+
+    // Rebuilds a level from its journal, if it has one. basePath is the level file the journal was started from.
+    static bool recover(const std::string& levelName, LevelData& level, std::string& basePath, size_t& numJournalEdits);
+
+private:
+    void addEdit(const LevelEdit& edit);
+    void flushEdits();
+    void takeSavedEdits();
+    void compact(const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
+
+    static std::string getJournalPath(const std::string& levelName);
+    static std::string getSnapshotPath(const std::string& levelName, int index);
+    static void removeAutosaveFiles(const std::string& levelName);
+
+    Bengine::ThreadPool m_worker;
+
+    std::vector<LevelEdit> m_pendingEdits;
+    size_t m_numJournalEdits = 0; ///< Edits in the journal, including the ones still on their way
+    unsigned int m_lastFlushTime = 0;
+    std::atomic<SaveResult> m_saveResult;
+    std::atomic<size_t> m_numSavedEdits; ///< Journal edits a finished save made unneeded, set by the worker
+
+    // Only used by tasks on the worker thread
+    std::string m_levelName;
+    std::string m_basePath;
+    bool m_journalStarted = false;
+};
@@ -0,0 +1,286 @@
+#include "LevelCooker.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Edges closer than this are treated as the same edge. Larger than b2_linearSlop,
+// which is the shortest edge a chain shape accepts.
+const float SNAP_DISTANCE = 0.01f;
+const float ANGLE_TOLERANCE = 0.0001f;
+// Groups that would need a bigger grid than this are left as separate boxes
+const size_t MAX_MERGE_CELLS = 1 << 22;
+
+enum Direction { EAST, NORTH, WEST, SOUTH };
+const int DIRECTION_X[4] = { 1, 0, -1, 0 };
+const int DIRECTION_Y[4] = { 0, 1, 0, -1 };
+
+struct MergeRect {
+    float minX, minY, maxX, maxY;
+    size_t box;
+};
+
+// Finds which group of touching rectangles each rectangle is in
+class DisjointSets
+{
+public:
+    DisjointSets(size_t size) : m_parents(size) {
+        for (size_t i = 0; i < size; i++) m_parents[i] = i;
+    }
+
+    size_t find(size_t i) {
+        while (m_parents[i] != i) {
+            m_parents[i] = m_parents[m_parents[i]];
+            i = m_parents[i];
+        }
+        return i;
+    }
+
+    void merge(size_t a, size_t b) { m_parents[find(a)] = find(b); }
+
+private:
+    std::vector<size_t> m_parents;
+};
+
+// b2DynamicTree query callback that links a rectangle with everything it shares an edge with
+class TouchQuery
+{
+public:
+    TouchQuery(const b2DynamicTree& tree, const std::vector<MergeRect>& rects, DisjointSets& sets) :
+        m_tree(tree), m_rects(rects), m_sets(sets)
+    {
+        // Empty
+    }
+
+    bool QueryCallback(int32 proxyId) {
+        size_t other = (size_t)m_tree.GetUserData(proxyId);
+        if (other == current) return true;
+
+        const MergeRect& a = m_rects[current];
+        const MergeRect& b = m_rects[other];
+        float overlapX = std::min(a.maxX, b.maxX) - std::max(a.minX, b.minX);
+        float overlapY = std::min(a.maxY, b.maxY) - std::max(a.minY, b.minY);
+
+        // Touching along an edge, not just at a corner
+        if (overlapX >= -SNAP_DISTANCE && overlapY >= -SNAP_DISTANCE && std::max(overlapX, overlapY) > SNAP_DISTANCE) {
+            m_sets.merge(current, other);
+        }
+        return true;
+    }
+
+    size_t current = 0;
+
+private:
+    const b2DynamicTree& m_tree;
+    const std::vector<MergeRect>& m_rects;
+    DisjointSets& m_sets;
+};
+
+// Gets the bounds of a static box if it's lined up with the axes
+static bool getAxisAlignedRect(const Box& box, MergeRect& rect)
+{
+    if (box.getIsDynamic() || !box.getBody()) return false;
+
+    // Quarter turns are fine, they just swap the sides
+    const float QUARTER_TURN = b2_pi / 2.0f;
+    float turns = std::round(box.getAngle() / QUARTER_TURN);
+    if (std::fabs(box.getAngle() - turns * QUARTER_TURN) > ANGLE_TOLERANCE) return false;
+
+    glm::vec2 halfDims = box.getDimensions() / 2.0f;
+    if ((int)turns % 2 != 0) std::swap(halfDims.x, halfDims.y);
+
+    // Too thin to have edges longer than the snap distance
+    if (halfDims.x * 2.0f <= SNAP_DISTANCE || halfDims.y * 2.0f <= SNAP_DISTANCE) return false;
+
+    glm::vec2 position = box.getPosition();
+    rect.minX = position.x - halfDims.x;
+    rect.minY = position.y - halfDims.y;
+    rect.maxX = position.x + halfDims.x;
+    rect.maxY = position.y + halfDims.y;
+    return true;
+}
+
+// Collapses coordinates within SNAP_DISTANCE of each other into grid lines
+static void makeGridLines(std::vector<float>& values, std::vector<float>& lines)
+{
+    std::sort(values.begin(), values.end());
+
+    lines.clear();
+    for (float v : values) {
+        if (lines.empty() || v - lines.back() > SNAP_DISTANCE) lines.push_back(v);
+    }
+}
+
+// The grid line a coordinate was snapped to
+static int getGridLine(const std::vector<float>& lines, float value)
+{
+    return (int)(std::upper_bound(lines.begin(), lines.end(), value) - lines.begin()) - 1;
+}
+
+// Builds the outlines of one group of touching rectangles and adds them to body as chain loops.
+// Returns false if the group is too big to merge.
+static bool addOutlines(b2Body* body, const std::vector<MergeRect>& rects, const std::vector<size_t>& group)
+{
+    // Grid lines through every rectangle edge
+    std::vector<float> values;
+    std::vector<float> xLines, yLines;
+    values.reserve(group.size() * 2);
+
+    for (size_t i : group) {
+        values.push_back(rects[i].minX);
+        values.push_back(rects[i].maxX);
+    }
+    makeGridLines(values, xLines);
+
+    values.clear();
+    for (size_t i : group) {
+        values.push_back(rects[i].minY);
+        values.push_back(rects[i].maxY);
+    }
+    makeGridLines(values, yLines);
+
+    const int width = (int)xLines.size() - 1;
+    const int height = (int)yLines.size() - 1;
+    if ((size_t)width * (size_t)height > MAX_MERGE_CELLS) return false;
+
+    // Mark the cells the rectangles cover
+    std::vector<unsigned char> cells(width * height, 0);
+    for (size_t i : group) {
+        int x0 = getGridLine(xLines, rects[i].minX), x1 = getGridLine(xLines, rects[i].maxX);
+        int y0 = getGridLine(yLines, rects[i].minY), y1 = getGridLine(yLines, rects[i].maxY);
+        for (int y = y0; y < y1; y++) {
+            std::fill(cells.begin() + y * width + x0, cells.begin() + y * width + x1, (unsigned char)1);
+        }
+    }
+
+    auto isCovered = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < width && y < height && cells[y * width + x] != 0;
+    };
+
+    // Every side between a covered and an empty cell is an outline edge, pointing so the covered cell is on its left.
+    // Each grid vertex stores one bit per direction an edge leaves it in.
+    const int vertexWidth = width + 1;
+    std::vector<unsigned char> edges(vertexWidth * (height + 1), 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!isCovered(x, y)) continue;
+            if (!isCovered(x, y - 1)) edges[y * vertexWidth + x] |= 1 << EAST;
+            if (!isCovered(x + 1, y)) edges[y * vertexWidth + x + 1] |= 1 << NORTH;
+            if (!isCovered(x, y + 1)) edges[(y + 1) * vertexWidth + x + 1] |= 1 << WEST;
+            if (!isCovered(x - 1, y)) edges[(y + 1) * vertexWidth + x] |= 1 << SOUTH;
+        }
+    }
+
+    // Follow the edges into loops. Outer outlines come out counter-clockwise and holes clockwise.
+    std::vector<b2Vec2> loop;
+    for (size_t start = 0; start < edges.size(); start++) {
+        while (edges[start]) {
+            const int startX = (int)start % vertexWidth;
+            const int startY = (int)start / vertexWidth;
+            int startDirection = 0;
+            while (!(edges[start] & (1 << startDirection))) startDirection++;
+
+            loop.clear();
+            int x = startX, y = startY;
+            int direction = startDirection;
+            bool closed = false;
+            while (true) {
+                edges[y * vertexWidth + x] &= ~(1 << direction);
+                x += DIRECTION_X[direction];
+                y += DIRECTION_Y[direction];
+
+                if (x == startX && y == startY) {
+                    closed = true;
+                    if (direction != startDirection) loop.push_back(b2Vec2(xLines[x], yLines[y]));
+                    break;
+                }
+
+                // Where two cells only touch at a corner there are two ways on. Preferring the left
+                // turn keeps the outline from crossing itself, it may just pass that corner twice.
+                unsigned char out = edges[y * vertexWidth + x];
+                int next;
+                if (out & (1 << ((direction + 1) & 3))) next = (direction + 1) & 3;
+                else if (out & (1 << direction)) next = direction;
+                else if (out & (1 << ((direction + 3) & 3))) next = (direction + 3) & 3;
+                else break;
+
+                // Only corners become chain vertices
+                if (next != direction) loop.push_back(b2Vec2(xLines[x], yLines[y]));
+                direction = next;
+            }
+
+            if (closed && loop.size() >= 3) {
+                b2ChainShape chain;
+                chain.CreateLoop(loop.data(), (int32)loop.size());
+
+                b2FixtureDef fixtureDef;
+                fixtureDef.shape = &chain;
+                fixtureDef.friction = 0.3f; ///< Same as Box
+                body->CreateFixture(&fixtureDef);
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t LevelCooker::mergeStaticBoxes(b2World* world, std::vector<Box>& boxes)
+{
+    std::vector<MergeRect> rects;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        MergeRect rect;
+        if (getAxisAlignedRect(boxes[i], rect)) {
+            rect.box = i;
+            rects.push_back(rect);
+        }
+    }
+    if (rects.empty()) return 0;
+
+    // Group rectangles that share an edge
+    DisjointSets sets(rects.size());
+    {
+        b2DynamicTree tree;
+        for (size_t i = 0; i < rects.size(); i++) {
+            b2AABB aabb;
+            aabb.lowerBound.Set(rects[i].minX - SNAP_DISTANCE, rects[i].minY - SNAP_DISTANCE);
+            aabb.upperBound.Set(rects[i].maxX + SNAP_DISTANCE, rects[i].maxY + SNAP_DISTANCE);
+            tree.CreateProxy(aabb, (void*)i);
+        }
+
+        TouchQuery query(tree, rects, sets);
+        for (size_t i = 0; i < rects.size(); i++) {
+            b2AABB aabb;
+            aabb.lowerBound.Set(rects[i].minX - SNAP_DISTANCE, rects[i].minY - SNAP_DISTANCE);
+            aabb.upperBound.Set(rects[i].maxX + SNAP_DISTANCE, rects[i].maxY + SNAP_DISTANCE);
+            query.current = i;
+            tree.Query(&query, aabb);
+        }
+    }
+
+    // List the rectangles of each group
+    std::vector<std::vector<size_t>> groups(rects.size());
+    for (size_t i = 0; i < rects.size(); i++) {
+        groups[sets.find(i)].push_back(i);
+    }
+
+    b2Body* body = nullptr;
+    size_t numMerged = 0;
+    for (auto& group : groups) {
+        // A lone box is already as simple as it gets
+        if (group.size() < 2) continue;
+
+        if (!body) {
+            b2BodyDef bodyDef;
+            bodyDef.type = b2_staticBody;
+            body = world->CreateBody(&bodyDef);
+        }
+
+        if (!addOutlines(body, rects, group)) continue;
+
+        for (size_t i : group) {
+            boxes[rects[i].box].detachBody(world);
+        }
+        numMerged += group.size();
+    }
+
+    return numMerged;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <vector>
+
+#include "Box.h"
+
+// Prepares a loaded level for playing. The editor works on the uncooked level.
+class LevelCooker
+{
+public:
+    // Replaces touching axis-aligned static boxes with chain shape outlines on one static body.
+    // Far fewer broad-phase proxies, and nothing catches on the seams between boxes.
+    // The merged boxes keep their render data but no longer have bodies. Returns how many were merged.
+    static size_t mergeStaticBoxes(b2World* world, std::vector<Box>& boxes);
+};
@@ -9,6 +9,11 @@ const float SIZE_CHANGE_SPEED = 0.05f;
 const float LIGHT_SELECT_RADIUS = 0.5f;
 const b2Vec2 GRAVITY(0.0f, -25.0f);
 
+static bool sameColor(const Bengine::ColorRGBA8& a, const Bengine::ColorRGBA8& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
 LevelEditorScreen::LevelEditorScreen(Bengine::Window* window) :
     m_window(window)
 {
@@ -64,6 +69,10 @@ void LevelEditorScreen::onEntry()
 
     m_debugRenderer.init();
 
+    // Time the CEGUI pass on the GPU
+    m_gpuTimer.init();
+    m_guiPass = m_gpuTimer.addPass("GUI pass");
+
     // Init UI
     initUI();
 
@@ -71,12 +80,26 @@ void LevelEditorScreen::onEntry()
     m_spriteBatch.init();
 
     m_world = std::make_unique<b2World>(GRAVITY);
+    m_levelIndex.init(m_world.get(), LIGHT_SELECT_RADIUS);
 
     // Init shaders
     initShaders();
 
     m_blankTexture = Bengine::ResourceManager::getTexture("Assets/blank.png");
     m_spriteFont = std::make_unique<Bengine::SpriteFont>("Fonts/chintzy.ttf", 32);
+
+    // Bring back the untitled level if the editor was closed without saving it
+    m_autosaver.init();
+    LevelData level;
+    std::string basePath;
+    size_t numEdits;
+    if (LevelAutosaver::recover(UNTITLED_LEVEL, level, basePath, numEdits)) {
+        loadLevel(level);
+        m_autosaver.setLevel(UNTITLED_LEVEL, basePath, true, numEdits);
+    }
+    else {
+        m_autosaver.setLevel(UNTITLED_LEVEL, "");
+    }
 }
 
 void LevelEditorScreen::onExit()
@@ -88,6 +111,8 @@ void LevelEditorScreen::onExit()
     m_spriteBatch.dispose();
     m_widgetLabels.clear();
     m_debugRenderer.dispose();
+    m_gpuTimer.dispose();
+    m_autosaver.dispose();
 
     clearLevel();
     m_world.reset();
@@ -101,6 +126,10 @@ void LevelEditorScreen::clearLevel()
     m_lights.clear();
     m_hasPlayer = false;
 
+    // A fresh world, so the old bodies can't be picked any more
+    m_world = std::make_unique<b2World>(GRAVITY);
+    m_levelIndex.init(m_world.get(), LIGHT_SELECT_RADIUS);
+
     m_rotation = 0.0f;
     m_width = 0.0f;
     m_height = 0.0f;
@@ -138,6 +167,19 @@ void LevelEditorScreen::clearLevel()
     m_colorPickerAlpha = 255.0f;
 }
 
+void LevelEditorScreen::loadLevel(const LevelData& level)
+{
+    std::vector<Box> boxes;
+    std::vector<Light> lights;
+    LevelReaderWriter::buildLevel(level, m_world.get(), m_player, boxes, lights);
+    m_hasPlayer = level.hasPlayer;
+
+    m_levelIndex.setBoxIndices(boxes);
+    m_levelIndex.setLights(lights);
+    m_boxes.assign(std::move(boxes));
+    m_lights.assign(std::move(lights));
+}
+
 void LevelEditorScreen::resetColorPickerValues()
 {
     m_rSlider->setCurrentValue(255);
@@ -200,16 +242,40 @@ void LevelEditorScreen::update()
 
     // Delete selected object
     if (m_inputManager.isKeyPressed(SDLK_DELETE)) {
+        // The last object moves into the removed one's index, everything else stays put
         if (m_selectedLight != NO_LIGHT) {
-            m_lights.erase(m_lights.begin() + m_selectedLight);
+            int index = m_lights.getIndex(m_selectedLight);
+            m_lights.remove(m_selectedLight);
+            m_levelIndex.removeLight(index);
+            m_autosaver.removeLight(index);
             m_selectedLight = NO_LIGHT;
         }
         else if (m_selectedBox != NO_BOX) {
-            m_boxes.erase(m_boxes.begin() + m_selectedBox);
+            int index = m_boxes.getIndex(m_selectedBox);
+            m_boxes[m_selectedBox].destroy(m_world.get());
+            m_boxes.remove(m_selectedBox);
+            if ((size_t)index < m_boxes.size()) m_levelIndex.setBoxIndex(m_boxes.getValues()[index], index);
+            m_autosaver.removeBox(index);
             m_selectedBox = NO_BOX;
         }
     }
 
+    m_autosaver.update(m_hasPlayer ? &m_player : nullptr, m_boxes.getValues(), m_lights.getValues());
+
+    // Saves finish in the background
+    switch (m_autosaver.getSaveResult()) {
+    case SaveResult::SUCCESS:
+        m_saveWindow->setAlpha(0.0f);
+        m_saveWindow->disable();
+        puts("Level saved succesfully!");
+        break;
+    case SaveResult::FAILURE:
+        puts("Failed to save level. Did you specify a file name?");
+        break;
+    case SaveResult::NONE:
+        break;
+    }
+
     m_gui.update();
 }
 
@@ -462,6 +528,9 @@ void LevelEditorScreen::initUI()
 
 void LevelEditorScreen::draw()
 {
+    // Pick up the pass times the GPU has finished since last frame
+    m_gpuTimer.update();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glClearColor(0.0f, 0.0f, 0.4f, 1.0f);
 
@@ -536,7 +605,7 @@ void LevelEditorScreen::drawWorld()
 
             glm::vec4 destRect(box.getPosition().x - box.getDimensions().x / 2.0f, box.getPosition().y - box.getDimensions().y / 2.0f, box.getDimensions());
 
-            m_debugRenderer.drawBox(destRect, color, box.getBody()->GetAngle());
+            m_debugRenderer.drawBox(destRect, color, box.getAngle());
         }
 
         for (auto& l : m_lights) {
@@ -676,6 +745,7 @@ void LevelEditorScreen::drawUI()
 
     m_textureProgram.unuse();
 
+    Bengine::GpuPassScope guiPass(m_gpuTimer, m_guiPass);
     m_gui.draw();
 }
 
@@ -767,13 +837,16 @@ void LevelEditorScreen::updateMouseDown(SDL_Event& evnt)
                 pos = m_camera.convertScreenToWorld(glm::vec2(evnt.button.x, evnt.button.y));
                 m_player.init(m_world.get(), pos, glm::vec2(2.0f), glm::vec2(1.0f, 1.8f), color);
                 m_hasPlayer = true;
+                m_autosaver.setPlayer(m_player);
                 break;
             case ObjectMode::PLATFORM:
                 if (m_width > 0.0f && m_height > 0.0f) {
                     pos = m_camera.convertScreenToWorld(glm::vec2(evnt.button.x, evnt.button.y));
                     glm::vec4 uvRect(pos.x, pos.x, m_width, m_height);
                     box.init(m_world.get(), pos, glm::vec2(m_width, m_height), texture, color, m_physicsMode == PhysicsMode::DYNAMIC, m_rotation, false, uvRect);
-                    m_boxes.push_back(box);
+                    m_boxes.insert(box);
+                    m_levelIndex.setBoxIndex(box, m_boxes.size() - 1);
+                    m_autosaver.setBox(m_boxes.size() - 1, box);
                     std::cout << "Is dynamic: " << (m_physicsMode == PhysicsMode::DYNAMIC) << "\n";
                 }
                 break;
@@ -782,7 +855,9 @@ void LevelEditorScreen::updateMouseDown(SDL_Event& evnt)
                 light.size = m_lightSize;
                 color.a = (GLubyte)m_colorPickerAlpha;
                 light.color = color;
-                m_lights.push_back(light);
+                m_lights.insert(light);
+                m_levelIndex.addLight(light);
+                m_autosaver.setLight(m_lights.size() - 1, light);
                 break;
             case ObjectMode::FINISH:
                 // TODO: Implement this
@@ -793,15 +868,9 @@ void LevelEditorScreen::updateMouseDown(SDL_Event& evnt)
         else {
             pos = m_camera.convertScreenToWorld(glm::vec2(evnt.button.x, evnt.button.y));
 
-            m_selectedLight = NO_LIGHT;
-
             // Check for lights
-            for (size_t i = 0; i < m_lights.size(); i++) {
-                if (inLightSelect(m_lights[i], pos)) {
-                    m_selectedLight = i;
-                    break;
-                }
-            }
+            int index = m_levelIndex.pickLight(pos);
+            m_selectedLight = (index != -1) ? m_lights.getHandle(index) : NO_LIGHT;
 
             // If a light was seleccted
             if (m_selectedLight != NO_LIGHT) {
@@ -824,15 +893,9 @@ void LevelEditorScreen::updateMouseDown(SDL_Event& evnt)
                 break; ///< If we selected a light, don't check for boxes
             }
 
-            m_selectedBox = NO_BOX;
-
             // Check for boxes
-            for (size_t i = 0; i < m_boxes.size(); i++) {
-                if (m_boxes[i].pointInBox(pos.x, pos.y)) {
-                    m_selectedBox = i;
-                    break;
-                }
-            }
+            index = m_levelIndex.pickBox(pos);
+            m_selectedBox = (index != -1) ? m_boxes.getHandle(index) : NO_BOX;
 
             // If a box was selected
             if (m_selectedBox != NO_BOX) {
@@ -911,16 +974,28 @@ void LevelEditorScreen::refreshSelectedBox()
 
 void LevelEditorScreen::refreshSelectedBox(const glm::vec2& pos)
 {
-    Box newBox;
     static Bengine::GLTexture texture = Bengine::ResourceManager::getTexture("Assets/bricks_top.png");
     Bengine::ColorRGBA8 color((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, 255);
-    glm::vec4 uvRect(pos.x, pos.y, m_width, m_height);
+    glm::vec2 dimensions(m_width, m_height);
+    bool isDynamic = (m_physicsMode == PhysicsMode::DYNAMIC);
+
+    // This runs every frame while a box is selected, so skip the edit when nothing changed
+    Box& box = m_boxes[m_selectedBox];
+    bool moved = (box.getPosition() != pos || box.getAngle() != m_rotation);
+    bool resized = (box.getDimensions() != dimensions);
+    if (!moved && !resized && box.getIsDynamic() == isDynamic && sameColor(box.getColor(), color)) {
+        return;
+    }
 
-    newBox.init(m_world.get(), pos, glm::vec2(m_width, m_height), texture, color, m_physicsMode == PhysicsMode::DYNAMIC, m_rotation, false, uvRect);
+    // Edit the body in place, so dragging doesn't create and destroy bodies every frame
+    if (resized) box.setDimensions(dimensions);
+    if (box.getIsDynamic() != isDynamic) box.setIsDynamic(isDynamic);
+    if (moved) box.setTransform(pos, m_rotation);
+    box.setTexture(texture);
+    box.setColor(color);
+    box.setUvRect(glm::vec4(pos.x, pos.y, m_width, m_height));
 
-    // Destroy the old box and replace it with the new one
-    m_boxes[m_selectedBox].destroy(m_world.get());
-    m_boxes[m_selectedBox] = newBox;
+    m_autosaver.setBox(m_boxes.getIndex(m_selectedBox), box);
 }
 
 void LevelEditorScreen::refreshSelectedLight()
@@ -936,7 +1011,15 @@ void LevelEditorScreen::refreshSelectedLight(const glm::vec2& pos)
     newLight.size = m_lightSize;
     newLight.color = Bengine::ColorRGBA8((GLubyte)m_colorPickerRed, (GLubyte)m_colorPickerGreen, (GLubyte)m_colorPickerBlue, (GLubyte)m_colorPickerAlpha);
 
+    const Light& oldLight = m_lights[m_selectedLight];
+    if (oldLight.position == newLight.position && oldLight.size == newLight.size && sameColor(oldLight.color, newLight.color)) {
+        return;
+    }
+
     m_lights[m_selectedLight] = newLight;
+    int index = m_lights.getIndex(m_selectedLight);
+    m_levelIndex.moveLight(index, newLight);
+    m_autosaver.setLight(index, newLight);
 }
 
 bool LevelEditorScreen::isMouseInUI()
@@ -950,11 +1033,6 @@ bool LevelEditorScreen::isMouseInUI()
             y >= m_groupBox->getYPosition().d_scale * SH && y <= m_groupBox->getYPosition().d_scale * SH + m_groupBox->getHeight().d_scale * SH);
 }
 
-bool LevelEditorScreen::inLightSelect(Light light, glm::vec2 pos)
-{
-    return (glm::length(pos - light.position) <= LIGHT_SELECT_RADIUS);
-}
-
 void LevelEditorScreen::onColorPickerRedChange()
 {
     m_colorPickerRed = m_rSlider->getCurrentValue();
@@ -1128,37 +1206,44 @@ void LevelEditorScreen::onSave()
         return;
     }
 
+    std::string levelName(m_saveWindowCombobox->getText().c_str());
+    if (levelName.empty()) {
+        puts("Failed to save level. Did you specify a file name?");
+        return;
+    }
+
     puts("Saving game...");
 
     Bengine::IOManager::makeDirectory("Levels");
 
-    // Save in text mode
-    std::string filePath = "Levels/" + std::string(m_saveWindowCombobox->getText().c_str());
-    if (LevelReaderWriter::saveAsText(filePath, m_player, m_boxes, m_lights)) {
-        m_saveWindow->setAlpha(0.0f);
-        m_saveWindow->disable();
-        puts("Level saved succesfully!");
-    }
-    else {
-        puts("Failed to save level. Did you specify a file name?");
-    }
+    // Save in text mode. The file is written in the background and update() reports how it went.
+    m_autosaver.save("Levels/" + levelName, levelName, m_player, m_boxes.getValues(), m_lights.getValues());
 }
 
 void LevelEditorScreen::onLoad()
 {
     puts("Loading level...");
-    std::string filePath = "Levels/" + std::string(m_loadWindowCombobox->getText().c_str());
+    std::string levelName(m_loadWindowCombobox->getText().c_str());
+    std::string filePath = "Levels/" + levelName;
 
     // Clear the level
     clearLevel();
 
+    // Unsaved edits from a session that crashed win over the file
+    LevelData level;
+    std::string basePath;
+    size_t numEdits = 0;
+    bool recovered = LevelAutosaver::recover(levelName, level, basePath, numEdits);
+
     // Load the file
-    if (!LevelReaderWriter::loadFromText(filePath, m_world.get(), m_player, m_boxes, m_lights)) {
+    if (!recovered && !LevelReaderWriter::loadFromText(filePath, level)) {
         puts("Failed to load the level!");
+        m_autosaver.setLevel(UNTITLED_LEVEL, "");
         return;
     }
     else {
-        m_hasPlayer = true;
+        loadLevel(level);
+        m_autosaver.setLevel(levelName, recovered ? basePath : filePath, recovered, numEdits);
         puts("Loaded level successfully!");
     }
 
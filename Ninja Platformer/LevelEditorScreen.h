@@ -10,12 +10,16 @@
 #include <Bengine/SpriteFont.h>
 #include <Bengine/GLTexture.h>
 #include <Bengine/DebugRenderer.h>
+#include <Bengine/GpuTimer.h>
+#include <Bengine/SlotMap.h>
 #include <memory>
 #include "Box.h"
 #include "Light.h"
 #include "Player.h"
 #include "ScreenIndices.h"
 #include "LevelReaderWriter.h"
+#include "LevelAutosaver.h"
+#include "LevelSpatialIndex.h"
 #include <vector>
 
 enum class PhysicsMode {
@@ -35,8 +39,8 @@ enum class SelectionMode {
     PLACE
 };
 
-const int NO_BOX = -1;
-const int NO_LIGHT = -1;
+const Bengine::SlotHandle NO_BOX = Bengine::SlotHandle();
+const Bengine::SlotHandle NO_LIGHT = Bengine::SlotHandle();
 
 // A label for a CEGUI widget.
 class WidgetLabel {
@@ -80,6 +84,7 @@ private:
     void drawWorld();
     void drawUI();
     void clearLevel(); ///< Resets everything to original values or destroys them
+    void loadLevel(const LevelData& level);
     void resetColorPickerValues();
 
     void setObjectWidgetVisibility(bool visibility);
@@ -96,7 +101,6 @@ private:
     void refreshSelectedLight(const glm::vec2& pos);
 
     bool isMouseInUI(); ///< Checks if the mouse in inside the UI box
-    bool inLightSelect(Light light, glm::vec2 pos); ///< Checks if a point is inside the light's select radius
 
     /******************************************/
     /* Event handlers                         */
@@ -190,17 +194,19 @@ private:
     bool m_isDragging = false;
     glm::vec2 m_selectOffset;
     bool m_hasDragged = false;
-    int m_selectedBox = NO_BOX;
-    int m_selectedLight = NO_LIGHT;
+    Bengine::SlotHandle m_selectedBox = NO_BOX;
+    Bengine::SlotHandle m_selectedLight = NO_LIGHT;
 
     std::vector<CEGUI::ListboxItem*> m_saveBoxListItems;
     std::vector<CEGUI::ListboxItem*> m_loadBoxListItems;
     
     std::unique_ptr<b2World> m_world;
-    std::vector<Light> m_lights;
-    std::vector<Box> m_boxes;
+    Bengine::SlotMap<Light> m_lights;
+    Bengine::SlotMap<Box> m_boxes;
+    LevelSpatialIndex m_levelIndex; ///< For picking boxes and lights, by their index in the slot maps
 
     Player m_player;
+    LevelAutosaver m_autosaver;
 
     Bengine::Camera2D m_camera;
     Bengine::Camera2D m_uiCamera;
@@ -221,5 +227,7 @@ private:
     Bengine::GLSLProgram m_lightProgram;
     Bengine::DebugRenderer m_debugRenderer;
     std::unique_ptr<Bengine::SpriteFont> m_spriteFont;
+    Bengine::GpuTimer m_gpuTimer;
+    int m_guiPass = 0;
 };
 
@@ -1,18 +1,441 @@
 #include "LevelReaderWriter.h"
 
 #include <Bengine/ResourceManager.h>
+#include <Bengine/IOManager.h>
+#include <Bengine/Profiler.h>
 #include <fstream>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 // When a new version is made, add it here
 const unsigned int TEXT_VERSION_0 = 100;
+const unsigned int TEXT_VERSION_1 = 101; ///< Colors as numbers, round-trip floats, one box per line
 
 // Change this according to what version is being used
-const unsigned int TEXT_VERSION = TEXT_VERSION_0;
+const unsigned int TEXT_VERSION = TEXT_VERSION_1;
+
+// Levels with at least this many boxes get their box records parsed on multiple threads
+const size_t PARALLEL_BOX_THRESHOLD = 4096;
+
+// Reads whitespace separated tokens straight out of a file buffer.
+// Numbers are parsed by hand so reading doesn't go through iostreams or the locale.
+class TextTokenizer {
+public:
+    TextTokenizer(const char* begin, const char* end) : m_ptr(begin), m_end(end) {}
+
+    bool readFloat(float& value);
+    bool readUInt(unsigned int& value);
+    bool readSize(size_t& value);
+    bool readBool(bool& value);
+    bool readColorValue(GLubyte& value); ///< Decimal 0-255 (version 1)
+    bool readRawByte(GLubyte& value); ///< A single byte after one separator (version 0)
+    bool readToken(const char*& token, size_t& length);
+
+    const char* getPosition() const { return m_ptr; }
+    void setPosition(const char* position) { m_ptr = position; }
+    const char* getEnd() const { return m_end; }
+
+private:
+    static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f'; }
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    void skipWhitespace() { while (m_ptr < m_end && isSpace(*m_ptr)) m_ptr++; }
+    bool readUInt64(uint64_t& value);
+
+    const char* m_ptr;
+    const char* m_end;
+};
+
+bool TextTokenizer::readFloat(float& value)
+{
+    // Powers of ten that are exactly representable as a float
+    static const float POWERS_OF_TEN[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    const uint64_t MAX_EXACT_MANTISSA = 1 << 24;
+
+    skipWhitespace();
+    if (m_ptr == m_end) return false;
+
+    const char* p = m_ptr;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+
+    while (p < m_end && isDigit(*p)) {
+        mantissa = mantissa * 10 + (*p++ - '0');
+        numDigits++;
+    }
+    if (p < m_end && *p == '.') {
+        p++;
+        while (p < m_end && isDigit(*p)) {
+            mantissa = mantissa * 10 + (*p++ - '0');
+            numDigits++;
+            exponent--;
+        }
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < m_end && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            p++;
+        }
+        int e = 0;
+        while (p < m_end && isDigit(*p)) {
+            if (e < 1000) e = e * 10 + (*p - '0');
+            p++;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    // Fast path: the mantissa and the power of ten are both exact floats, so a single
+    // multiply or divide gives the correctly rounded result
+    if (numDigits > 0 && numDigits <= 19 && mantissa <= MAX_EXACT_MANTISSA &&
+        exponent >= -10 && exponent <= 10 && (p == m_end || isSpace(*p))) {
+        float f = (float)mantissa;
+        if (exponent < 0) {
+            f /= POWERS_OF_TEN[-exponent];
+        }
+        else {
+            f *= POWERS_OF_TEN[exponent];
+        }
+        value = negative ? -f : f;
+        m_ptr = p;
+        return true;
+    }
+
+    // Everything else (long mantissas, big exponents, inf, nan) goes through strtof.
+    // Tokens are always followed by whitespace or the buffer's terminating null.
+    char* end = nullptr;
+    value = strtof(m_ptr, &end);
+    if (end == m_ptr || end > m_end) return false;
+    m_ptr = end;
+    return true;
+}
+
+bool TextTokenizer::readUInt64(uint64_t& value)
+{
+    skipWhitespace();
+    if (m_ptr == m_end || !isDigit(*m_ptr)) return false;
+
+    value = 0;
+    while (m_ptr < m_end && isDigit(*m_ptr)) {
+        value = value * 10 + (*m_ptr++ - '0');
+    }
+    return true;
+}
+
+bool TextTokenizer::readUInt(unsigned int& value)
+{
+    uint64_t v;
+    if (!readUInt64(v)) return false;
+    value = (unsigned int)v;
+    return true;
+}
+
+bool TextTokenizer::readSize(size_t& value)
+{
+    uint64_t v;
+    if (!readUInt64(v)) return false;
+    value = (size_t)v;
+    return true;
+}
+
+bool TextTokenizer::readBool(bool& value)
+{
+    uint64_t v;
+    if (!readUInt64(v)) return false;
+    value = (v != 0);
+    return true;
+}
+
+bool TextTokenizer::readColorValue(GLubyte& value)
+{
+    uint64_t v;
+    if (!readUInt64(v) || v > 255) return false;
+    value = (GLubyte)v;
+    return true;
+}
+
+bool TextTokenizer::readRawByte(GLubyte& value)
+{
+    // Version 0 wrote colors as raw characters, so they can't go through skipWhitespace
+    if (m_ptr < m_end && *m_ptr == ' ') m_ptr++;
+    if (m_ptr == m_end) return false;
+
+    // A newline byte saved in text mode on Windows comes back as "\r\n"
+    if (*m_ptr == '\r' && m_ptr + 1 < m_end && m_ptr[1] == '\n') m_ptr++;
+
+    value = (GLubyte)*m_ptr++;
+    return true;
+}
+
+bool TextTokenizer::readToken(const char*& token, size_t& length)
+{
+    skipWhitespace();
+    if (m_ptr == m_end) return false;
+
+    token = m_ptr;
+    while (m_ptr < m_end && !isSpace(*m_ptr)) m_ptr++;
+    length = m_ptr - token;
+    return true;
+}
+
+// A parsed box line. The texture path points into the file buffer until it's put in the texture table.
+struct BoxRecord {
+    BoxData box;
+    const char* texturePath;
+    size_t texturePathLength;
+};
+
+int LevelData::addTexturePath(const std::string& path)
+{
+    // Levels only use a handful of textures, and the last one is the most likely match
+    for (int i = (int)texturePaths.size() - 1; i >= 0; i--) {
+        if (texturePaths[i] == path) return i;
+    }
+    texturePaths.push_back(path);
+    return (int)texturePaths.size() - 1;
+}
+
+static bool readColor(TextTokenizer& tokenizer, Bengine::ColorRGBA8& color, bool rawBytes)
+{
+    if (rawBytes) {
+        return tokenizer.readRawByte(color.r) && tokenizer.readRawByte(color.g) &&
+               tokenizer.readRawByte(color.b) && tokenizer.readRawByte(color.a);
+    }
+    return tokenizer.readColorValue(color.r) && tokenizer.readColorValue(color.g) &&
+           tokenizer.readColorValue(color.b) && tokenizer.readColorValue(color.a);
+}
+
+static bool readPlayer(TextTokenizer& tokenizer, PlayerData& player, bool rawColors)
+{
+    return tokenizer.readFloat(player.position.x) && tokenizer.readFloat(player.position.y) &&
+           tokenizer.readFloat(player.drawDims.x) && tokenizer.readFloat(player.drawDims.y) &&
+           tokenizer.readFloat(player.collisionDims.x) && tokenizer.readFloat(player.collisionDims.y) &&
+           readColor(tokenizer, player.color, rawColors);
+}
+
+static bool readBoxRecord(TextTokenizer& tokenizer, BoxRecord& r, bool rawColors)
+{
+    BoxData& b = r.box;
+    return tokenizer.readFloat(b.position.x) && tokenizer.readFloat(b.position.y) &&
+           tokenizer.readFloat(b.dimensions.x) && tokenizer.readFloat(b.dimensions.y) &&
+           readColor(tokenizer, b.color, rawColors) &&
+           tokenizer.readFloat(b.uvRect.x) && tokenizer.readFloat(b.uvRect.y) &&
+           tokenizer.readFloat(b.uvRect.z) && tokenizer.readFloat(b.uvRect.w) &&
+           tokenizer.readFloat(b.angle) &&
+           tokenizer.readToken(r.texturePath, r.texturePathLength) &&
+           tokenizer.readBool(b.isDynamic) && tokenizer.readBool(b.fixedRotation);
+}
+
+static bool readLight(TextTokenizer& tokenizer, Light& light, bool rawColors)
+{
+    return tokenizer.readFloat(light.position.x) && tokenizer.readFloat(light.position.y) &&
+           tokenizer.readFloat(light.size) && readColor(tokenizer, light.color, rawColors);
+}
+
+static bool readLights(TextTokenizer& tokenizer, std::vector<Light>& lights, bool rawColors)
+{
+    size_t numLights;
+    if (!tokenizer.readSize(numLights)) return false;
+
+    lights.resize(numLights);
+    for (auto& l : lights) {
+        if (!readLight(tokenizer, l, rawColors)) return false;
+    }
+
+    return true;
+}
+
+// Parses the box lines in [first, last). Every line gets its own tokenizer so chunks are independent.
+static bool readBoxLines(const std::vector<const char*>& lineStarts, size_t first, size_t last, std::vector<BoxRecord>& records)
+{
+    for (size_t i = first; i < last; i++) {
+        TextTokenizer lineTokenizer(lineStarts[i], lineStarts[i + 1]);
+        if (!readBoxRecord(lineTokenizer, records[i], false)) return false;
+    }
+    return true;
+}
+
+// Moves the parsed records into the level and fills in the texture table
+static void addBoxRecords(std::vector<BoxRecord>& records, LevelData& level)
+{
+    std::string texturePath;
+    int texture = -1;
+
+    level.boxes.reserve(level.boxes.size() + records.size());
+    for (auto& r : records) {
+        // Most boxes share a texture, so only search the table when the path changes
+        if (texture == -1 || texturePath.size() != r.texturePathLength ||
+            memcmp(texturePath.data(), r.texturePath, r.texturePathLength) != 0) {
+            texturePath.assign(r.texturePath, r.texturePathLength);
+            texture = level.addTexturePath(texturePath);
+        }
+
+        r.box.texture = texture;
+        level.boxes.push_back(r.box);
+    }
+}
+
+// Appends the shortest decimal that reads back as exactly the same float
+static void appendFloat(std::string& buffer, float value, char separator)
+{
+    char str[32];
+    int length = 0;
+
+    // %g drops trailing zeros, and FLT_DIG (6) digits always survive a round trip,
+    // so the first precision that reads back identically is the shortest one
+    for (int precision = 6; precision <= 9; precision++) {
+        length = snprintf(str, sizeof(str), "%.*g", precision, value);
+        if (precision == 9) break;
+
+        // Check with the same parser the loader uses
+        float readBack;
+        TextTokenizer tokenizer(str, str + length);
+        if (tokenizer.readFloat(readBack) && memcmp(&readBack, &value, sizeof(float)) == 0) break;
+    }
+
+    buffer.append(str, length);
+    buffer += separator;
+}
+
+static void appendUInt(std::string& buffer, size_t value, char separator)
+{
+    char str[24];
+    int i = sizeof(str);
+    do {
+        str[--i] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    buffer.append(str + i, sizeof(str) - i);
+    buffer += separator;
+}
+
+static void appendColor(std::string& buffer, const Bengine::ColorRGBA8& color, bool rawBytes, char separator)
+{
+    if (rawBytes) {
+        buffer += (char)color.r; buffer += ' ';
+        buffer += (char)color.g; buffer += ' ';
+        buffer += (char)color.b; buffer += ' ';
+        buffer += (char)color.a; buffer += separator;
+    }
+    else {
+        appendUInt(buffer, color.r, ' ');
+        appendUInt(buffer, color.g, ' ');
+        appendUInt(buffer, color.b, ' ');
+        appendUInt(buffer, color.a, separator);
+    }
+}
+
+static void appendPlayer(std::string& buffer, const PlayerData& p, bool rawColors)
+{
+    appendFloat(buffer, p.position.x, ' ');
+    appendFloat(buffer, p.position.y, ' ');
+    appendFloat(buffer, p.drawDims.x, ' ');
+    appendFloat(buffer, p.drawDims.y, ' ');
+    appendFloat(buffer, p.collisionDims.x, ' ');
+    appendFloat(buffer, p.collisionDims.y, ' ');
+    appendColor(buffer, p.color, rawColors, '\n');
+}
+
+static void appendBox(std::string& buffer, const BoxData& b, const std::string& texturePath, bool rawColors)
+{
+    appendFloat(buffer, b.position.x, ' ');
+    appendFloat(buffer, b.position.y, ' ');
+    appendFloat(buffer, b.dimensions.x, ' ');
+    appendFloat(buffer, b.dimensions.y, ' ');
+    appendColor(buffer, b.color, rawColors, ' ');
+    appendFloat(buffer, b.uvRect.x, ' ');
+    appendFloat(buffer, b.uvRect.y, ' ');
+    appendFloat(buffer, b.uvRect.z, ' ');
+    appendFloat(buffer, b.uvRect.w, ' ');
+    appendFloat(buffer, b.angle, ' ');
+    buffer += texturePath;
+    buffer += ' ';
+    appendUInt(buffer, b.isDynamic, ' ');
+    appendUInt(buffer, b.fixedRotation, '\n');
+}
+
+static void appendLight(std::string& buffer, const Light& l, bool rawColors)
+{
+    appendFloat(buffer, l.position.x, ' ');
+    appendFloat(buffer, l.position.y, ' ');
+    appendFloat(buffer, l.size, ' ');
+    appendColor(buffer, l.color, rawColors, '\n');
+}
+
+static void appendLevel(std::string& buffer, unsigned int version, const LevelData& level)
+{
+    const bool rawColors = (version == TEXT_VERSION_0);
+
+    buffer.reserve(128 + level.boxes.size() * 128 + level.lights.size() * 48);
+
+    // Text version
+    appendUInt(buffer, version, '\n');
+
+    // Player information
+    appendPlayer(buffer, level.player, rawColors);
+
+    // Number of boxes
+    appendUInt(buffer, level.boxes.size(), '\n');
+
+    // Boxes' information, one box per line
+    for (auto& b : level.boxes) {
+        appendBox(buffer, b, level.texturePaths[b.texture], rawColors);
+    }
+
+    // Number of lights
+    appendUInt(buffer, level.lights.size(), '\n');
+
+    // Lights' information
+    for (auto& l : level.lights) {
+        appendLight(buffer, l, rawColors);
+    }
+}
+
+static bool writeBufferToFile(const std::string& filePath, const std::string& buffer)
+{
+    // Write next to the real file and swap it in, so a crash never leaves a half written level.
+    // Binary mode so the file is byte for byte what was built in memory.
+    std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (file.fail()) {
+            perror(tempPath.c_str());
+            return false;
+        }
+
+        file.write(buffer.data(), buffer.size());
+        if (file.fail()) return false;
+    }
+
+    return Bengine::IOManager::replaceFile(tempPath.c_str(), filePath.c_str());
+}
 
 bool LevelReaderWriter::saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights)
+{
+    LevelData level;
+    makeLevelData(&player, boxes, lights, level);
+    return saveAsText(filePath, level);
+}
+
+bool LevelReaderWriter::saveAsText(const std::string& filePath, const LevelData& level)
 {
     if (TEXT_VERSION == TEXT_VERSION_0) {
-        return saveAsTextV0(filePath, player, boxes, lights);
+        return saveAsTextV0(filePath, level);
+    }
+    else if (TEXT_VERSION == TEXT_VERSION_1) {
+        return saveAsTextV1(filePath, level);
     }
     else {
         puts("Unknown text version!");
@@ -22,126 +445,387 @@ bool LevelReaderWriter::saveAsText(const std::string& filePath, const Player& pl
 
 bool LevelReaderWriter::loadFromText(const std::string& filePath, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights)
 {
-    std::ifstream file(filePath);
-    if (file.fail()) {
-        perror(filePath.c_str());
+    LevelData level;
+    if (!loadFromText(filePath, level)) return false;
+
+    buildLevel(level, world, player, boxes, lights);
+    return true;
+}
+
+bool LevelReaderWriter::loadFromText(const std::string& filePath, LevelData& level)
+{
+    BENGINE_PROFILE_ZONE("LevelReaderWriter::loadFromText");
+
+    // Read the whole file in one go and tokenize it in memory
+    std::string buffer;
+    if (!Bengine::IOManager::readFileToBuffer(filePath, buffer)) {
         return false;
     }
 
+    TextTokenizer tokenizer(buffer.data(), buffer.data() + buffer.size());
+
     // Get version
-    unsigned int version;
-    file >> version;
+    unsigned int version = 0;
+    tokenizer.readUInt(version);
 
+    bool success;
     switch (version) {
     case TEXT_VERSION_0:
-        return loadAsTextV0(file, world, player, boxes, lights);
+        success = loadAsTextV0(tokenizer, level);
+        break;
+    case TEXT_VERSION_1:
+        success = loadAsTextV1(tokenizer, level);
         break;
     default:
         puts("Unknown version number in level file. File may be corrupted...");
         return false;
     }
+
+    if (!success) {
+        puts("Failed to parse level file. File may be corrupted...");
+    }
+    return success;
+}
+
+void LevelReaderWriter::makeLevelData(const Player* player, const std::vector<Box>& boxes, const std::vector<Light>& lights, LevelData& level)
+{
+    level.hasPlayer = (player != nullptr);
+    if (player) makePlayerData(*player, level.player);
+
+    level.boxes.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        makeBoxData(boxes[i], level.boxes[i]);
+        level.boxes[i].texture = level.addTexturePath(boxes[i].getTexture().filePath);
+    }
+
+    level.lights = lights;
+}
+
+void LevelReaderWriter::buildLevel(const LevelData& level, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights)
+{
+    BENGINE_PROFILE_ZONE("LevelReaderWriter::buildLevel");
+
+    if (level.hasPlayer) {
+        const PlayerData& p = level.player;
+        player.init(world, p.position, p.drawDims, p.collisionDims, p.color);
+    }
+
+    // Look up every texture once
+    std::vector<Bengine::GLTexture> textures(level.texturePaths.size());
+    for (size_t i = 0; i < textures.size(); i++) {
+        textures[i] = Bengine::ResourceManager::getTexture(level.texturePaths[i]);
+    }
+
+    // Box2D isn't thread safe, so the bodies are always made on the calling thread
+    boxes.reserve(boxes.size() + level.boxes.size());
+    for (auto& b : level.boxes) {
+        boxes.emplace_back();
+        boxes.back().init(world, b.position, b.dimensions, textures[b.texture], b.color, b.isDynamic, b.angle, b.fixedRotation, b.uvRect);
+    }
+
+    lights.insert(lights.end(), level.lights.begin(), level.lights.end());
 }
 
-bool LevelReaderWriter::saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights)
+void LevelReaderWriter::makeBoxData(const Box& box, BoxData& data)
 {
-    std::ofstream file(filePath);
+    data.position = box.getPosition();
+    data.dimensions = box.getDimensions();
+    data.uvRect = box.getUvRect();
+    data.color = box.getColor();
+    data.angle = box.getAngle();
+    data.isDynamic = box.getIsDynamic();
+    data.fixedRotation = box.getFixedRotation();
+}
+
+void LevelReaderWriter::makePlayerData(const Player& player, PlayerData& data)
+{
+    data.position = player.getPosition();
+    data.drawDims = player.getDrawDims();
+    data.collisionDims = player.getCollisionDims();
+    data.color = player.getColor();
+}
+
+bool LevelReaderWriter::startJournal(const std::string& filePath, const std::string& basePath, size_t baseSize)
+{
+    // J <text version> <base level size> <base level path>
+    // The path goes last because level names can have spaces in them
+    std::string buffer = "J ";
+    appendUInt(buffer, TEXT_VERSION_1, ' ');
+    appendUInt(buffer, baseSize, ' ');
+    buffer += basePath;
+    buffer += '\n';
+
+    return writeBufferToFile(filePath, buffer);
+}
+
+bool LevelReaderWriter::appendToJournal(const std::string& filePath, const std::vector<LevelEdit>& edits)
+{
+    std::string buffer;
+    for (auto& e : edits) {
+        switch (e.type) {
+        case LevelEditType::SET_PLAYER:
+            buffer += "P ";
+            appendPlayer(buffer, e.player, false);
+            break;
+        case LevelEditType::SET_BOX:
+            buffer += "B ";
+            appendUInt(buffer, e.index, ' ');
+            appendBox(buffer, e.box, e.texturePath, false);
+            break;
+        case LevelEditType::REMOVE_BOX:
+            buffer += "b ";
+            appendUInt(buffer, e.index, '\n');
+            break;
+        case LevelEditType::SET_LIGHT:
+            buffer += "L ";
+            appendUInt(buffer, e.index, ' ');
+            appendLight(buffer, e.light, false);
+            break;
+        case LevelEditType::REMOVE_LIGHT:
+            buffer += "l ";
+            appendUInt(buffer, e.index, '\n');
+            break;
+        case LevelEditType::SWAP_REMOVE_BOX:
+            buffer += "x ";
+            appendUInt(buffer, e.index, '\n');
+            break;
+        case LevelEditType::SWAP_REMOVE_LIGHT:
+            buffer += "y ";
+            appendUInt(buffer, e.index, '\n');
+            break;
+        }
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::app);
     if (file.fail()) {
         perror(filePath.c_str());
         return false;
     }
 
-    // Text version
-    file << TEXT_VERSION << '\n';
+    file.write(buffer.data(), buffer.size());
+    file.flush();
+    return !file.fail();
+}
 
-    // Player information
-    file << player.getPosition().x << ' ' << player.getPosition().y << ' '
-         << player.getDrawDims().x << ' ' << player.getDrawDims().y << ' '
-         << player.getCollisionDims().x << ' ' << player.getCollisionDims().y << ' '
-         << player.getColor().r << ' ' << player.getColor().g << ' '
-         << player.getColor().b << ' ' << player.getColor().a << '\n';
+bool LevelReaderWriter::loadJournal(const std::string& filePath, std::string& basePath, size_t& baseSize, std::vector<LevelEdit>& edits)
+{
+    std::string buffer;
+    if (!Bengine::IOManager::readFileToBuffer(filePath, buffer)) {
+        return false;
+    }
 
-    // Number of boxes
-    file << boxes.size() << '\n';
+    TextTokenizer tokenizer(buffer.data(), buffer.data() + buffer.size());
 
-    // Boxes' information
-    for (auto& b : boxes) {
-        file << b.getPosition().x << ' ' << b.getPosition().y << ' '
-             << b.getDimensions().x << ' ' << b.getDimensions().y << ' '
-             << b.getColor().r << ' ' << b.getColor().g << ' '
-             << b.getColor().b << ' ' << b.getColor().a << ' '
-             << b.getUvRect().x << ' ' << b.getUvRect().y << ' '
-             << b.getUvRect().z << ' ' << b.getUvRect().w << ' '
-             << b.getAngle() << ' ' << b.getTexture().filePath << ' '
-             << b.getIsDynamic() << ' ' << b.getFixedRotation() << '\n';
+    // Header
+    const char* token;
+    size_t length;
+    unsigned int version;
+    if (!tokenizer.readToken(token, length) || length != 1 || token[0] != 'J' ||
+        !tokenizer.readUInt(version) || version != TEXT_VERSION_1 ||
+        !tokenizer.readSize(baseSize)) {
+        puts("Unknown journal header. File may be corrupted...");
+        return false;
     }
 
-    // Number of lights
-    file << lights.size() << '\n';
+    { // The base path is the rest of the line
+        const char* start = tokenizer.getPosition();
+        const char* end = tokenizer.getEnd();
+        if (start != end && *start == ' ') start++;
+        const char* newLine = (const char*)memchr(start, '\n', end - start);
+        if (!newLine) return false;
 
-    // Lights' information
-    for (auto& l : lights) {
-        file << l.position.x << ' ' << l.position.y << ' '
-             << l.size << ' '
-             << l.color.r << ' ' << l.color.g << ' '
-             << l.color.b << ' ' << l.color.a << '\n';
+        const char* pathEnd = newLine;
+        if (pathEnd != start && pathEnd[-1] == '\r') pathEnd--;
+        basePath.assign(start, pathEnd);
+        tokenizer.setPosition(newLine + 1);
+    }
+
+    // Edits. A torn last line from a crash mid-write is dropped.
+    while (tokenizer.readToken(token, length)) {
+        LevelEdit e;
+        BoxRecord r;
+        bool ok = (length == 1);
+
+        if (ok) {
+            switch (token[0]) {
+            case 'P':
+                e.type = LevelEditType::SET_PLAYER;
+                ok = readPlayer(tokenizer, e.player, false);
+                break;
+            case 'B':
+                e.type = LevelEditType::SET_BOX;
+                ok = tokenizer.readSize(e.index) && readBoxRecord(tokenizer, r, false);
+                if (ok) {
+                    e.box = r.box;
+                    e.texturePath.assign(r.texturePath, r.texturePathLength);
+                }
+                break;
+            case 'b':
+                e.type = LevelEditType::REMOVE_BOX;
+                ok = tokenizer.readSize(e.index);
+                break;
+            case 'L':
+                e.type = LevelEditType::SET_LIGHT;
+                ok = tokenizer.readSize(e.index) && readLight(tokenizer, e.light, false);
+                break;
+            case 'l':
+                e.type = LevelEditType::REMOVE_LIGHT;
+                ok = tokenizer.readSize(e.index);
+                break;
+            case 'x':
+                e.type = LevelEditType::SWAP_REMOVE_BOX;
+                ok = tokenizer.readSize(e.index);
+                break;
+            case 'y':
+                e.type = LevelEditType::SWAP_REMOVE_LIGHT;
+                ok = tokenizer.readSize(e.index);
+                break;
+            default:
+                ok = false;
+                break;
+            }
+        }
+
+        if (!ok) {
+            puts("Journal ends with a broken edit, ignoring it");
+            break;
+        }
+        edits.push_back(e);
     }
 
     return true;
 }
 
-bool LevelReaderWriter::loadAsTextV0(std::ifstream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights)
+bool LevelReaderWriter::applyEdit(const LevelEdit& edit, LevelData& level)
 {
-    { // Read player
-        glm::vec2 pos;
-        glm::vec2 ddims;
-        glm::vec2 cdims;
-        Bengine::ColorRGBA8 color;
-        file >> pos.x >> pos.y >> ddims.x >> ddims.y >> cdims.x >> cdims.y >> color.r >> color.g >> color.b >> color.a;
-        player.init(world, pos, ddims, cdims, color);
+    switch (edit.type) {
+    case LevelEditType::SET_PLAYER:
+        level.player = edit.player;
+        level.hasPlayer = true;
+        return true;
+    case LevelEditType::SET_BOX:
+        if (edit.index > level.boxes.size()) return false;
+        if (edit.index == level.boxes.size()) level.boxes.emplace_back();
+        level.boxes[edit.index] = edit.box;
+        level.boxes[edit.index].texture = level.addTexturePath(edit.texturePath);
+        return true;
+    case LevelEditType::REMOVE_BOX:
+        if (edit.index >= level.boxes.size()) return false;
+        level.boxes.erase(level.boxes.begin() + edit.index);
+        return true;
+    case LevelEditType::SET_LIGHT:
+        if (edit.index > level.lights.size()) return false;
+        if (edit.index == level.lights.size()) level.lights.emplace_back();
+        level.lights[edit.index] = edit.light;
+        return true;
+    case LevelEditType::REMOVE_LIGHT:
+        if (edit.index >= level.lights.size()) return false;
+        level.lights.erase(level.lights.begin() + edit.index);
+        return true;
+    case LevelEditType::SWAP_REMOVE_BOX:
+        if (edit.index >= level.boxes.size()) return false;
+        level.boxes[edit.index] = level.boxes.back();
+        level.boxes.pop_back();
+        return true;
+    case LevelEditType::SWAP_REMOVE_LIGHT:
+        if (edit.index >= level.lights.size()) return false;
+        level.lights[edit.index] = level.lights.back();
+        level.lights.pop_back();
+        return true;
     }
+    return false;
+}
 
-    { // Read boxes
-        glm::vec2 pos;
-        glm::vec2 dims;
-        glm::vec4 uvRect;
-        Bengine::ColorRGBA8 color;
-        std::string texturePath;
-        Bengine::GLTexture texture;
-        bool fixedRotation;
-        float angle;
-        bool dynamic;
-        size_t num_boxes;
-
-        file >> num_boxes;
-        for (size_t i = 0; i < num_boxes; i++) {
-            file >> pos.x >> pos.y >> dims.x >> dims.y
-                 >> color.r >> color.g >> color.b >> color.a
-                 >> uvRect.x >> uvRect.y >> uvRect.z >> uvRect.w
-                 >> angle >> texturePath >> dynamic >> fixedRotation;
-
-            texture = Bengine::ResourceManager::getTexture(texturePath);
-
-            boxes.emplace_back();
-            boxes.back().init(world, pos, dims, texture, color, dynamic, angle, fixedRotation, uvRect);
+bool LevelReaderWriter::saveAsTextV0(const std::string& filePath, const LevelData& level)
+{
+    std::string buffer;
+    appendLevel(buffer, TEXT_VERSION_0, level);
+    return writeBufferToFile(filePath, buffer);
+}
+
+bool LevelReaderWriter::saveAsTextV1(const std::string& filePath, const LevelData& level)
+{
+    std::string buffer;
+    appendLevel(buffer, TEXT_VERSION_1, level);
+    return writeBufferToFile(filePath, buffer);
+}
+
+bool LevelReaderWriter::loadAsTextV0(TextTokenizer& tokenizer, LevelData& level)
+{
+    // Read player
+    if (!readPlayer(tokenizer, level.player, true)) return false;
+    level.hasPlayer = true;
+
+    { // Read boxes. Raw color bytes can be newlines, so this version is read front to back.
+        size_t numBoxes;
+        if (!tokenizer.readSize(numBoxes)) return false;
+
+        std::vector<BoxRecord> records(numBoxes);
+        for (auto& r : records) {
+            if (!readBoxRecord(tokenizer, r, true)) return false;
         }
+
+        addBoxRecords(records, level);
     }
 
-    { // Read lights
-        glm::vec2 pos;
-        float size;
-        Bengine::ColorRGBA8 color;
-        size_t num_lights;
+    // Read lights
+    return readLights(tokenizer, level.lights, true);
+}
+
+bool LevelReaderWriter::loadAsTextV1(TextTokenizer& tokenizer, LevelData& level)
+{
+    // Read player
+    if (!readPlayer(tokenizer, level.player, false)) return false;
+    level.hasPlayer = true;
+
+    { // Read boxes
+        size_t numBoxes;
+        if (!tokenizer.readSize(numBoxes)) return false;
+
+        // Find where every box line starts. The extra entry is where the lights begin.
+        std::vector<const char*> lineStarts(numBoxes + 1);
+        const char* p = tokenizer.getPosition();
+        const char* end = tokenizer.getEnd();
+        for (size_t i = 0; i <= numBoxes; i++) {
+            const char* newLine = (const char*)memchr(p, '\n', end - p);
+            p = newLine ? newLine + 1 : end;
+            lineStarts[i] = p;
+        }
 
-        file >> num_lights;
-        for (size_t i = 0; i < num_lights; i++) {
-            file >> pos.x >> pos.y >> size >> color.r >> color.g >> color.b >> color.a;
+        std::vector<BoxRecord> records(numBoxes);
 
-            lights.emplace_back();
-            lights.back().color = color;
-            lights.back().size = size;
-            lights.back().position = pos;
+        size_t numThreads = std::thread::hardware_concurrency();
+        if (numBoxes < PARALLEL_BOX_THRESHOLD || numThreads < 2) {
+            if (!readBoxLines(lineStarts, 0, numBoxes, records)) return false;
         }
+        else {
+            // Each thread parses one contiguous chunk of lines
+            std::vector<std::thread> threads;
+            std::vector<char> results(numThreads, 0);
+            size_t chunkSize = (numBoxes + numThreads - 1) / numThreads;
+
+            for (size_t t = 0; t < numThreads; t++) {
+                size_t first = t * chunkSize;
+                size_t last = std::min(first + chunkSize, numBoxes);
+                if (first >= last) {
+                    results[t] = 1;
+                    continue;
+                }
+                threads.emplace_back([&, t, first, last]() {
+                    results[t] = readBoxLines(lineStarts, first, last, records) ? 1 : 0;
+                });
+            }
+            for (auto& thread : threads) thread.join();
+
+            for (char result : results) {
+                if (!result) return false;
+            }
+        }
+
+        addBoxRecords(records, level);
+        tokenizer.setPosition(lineStarts[numBoxes]);
     }
 
-    return true;
+    // Read lights
+    return readLights(tokenizer, level.lights, false);
 }
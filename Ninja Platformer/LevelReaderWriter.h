@@ -1,17 +1,82 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Player.h"
 #include "Light.h"
 #include "Box.h"
 
+class TextTokenizer;
+
+// Plain copies of level objects that don't touch Box2D, so a level can be
+// snapshotted cheaply and written out on another thread
+struct PlayerData {
+    glm::vec2 position;
+    glm::vec2 drawDims;
+    glm::vec2 collisionDims;
+    Bengine::ColorRGBA8 color;
+};
+
+struct BoxData {
+    glm::vec2 position;
+    glm::vec2 dimensions;
+    glm::vec4 uvRect;
+    Bengine::ColorRGBA8 color;
+    float angle = 0.0f;
+    int texture = 0; ///< Index into LevelData::texturePaths
+    bool isDynamic = false;
+    bool fixedRotation = false;
+};
+
+struct LevelData {
+    // Returns the index of the path, adding it if it's new
+    int addTexturePath(const std::string& path);
+
+    bool hasPlayer = false;
+    PlayerData player;
+    std::vector<BoxData> boxes;
+    std::vector<Light> lights;
+    std::vector<std::string> texturePaths;
+};
+
+enum class LevelEditType { SET_PLAYER, SET_BOX, REMOVE_BOX, SET_LIGHT, REMOVE_LIGHT, SWAP_REMOVE_BOX, SWAP_REMOVE_LIGHT };
+
+// One change to a level. SET_BOX and SET_LIGHT with index == count append.
+// REMOVE shifts the following objects down, SWAP_REMOVE moves the last one into the gap.
+struct LevelEdit {
+    LevelEditType type;
+    size_t index = 0;
+    PlayerData player;
+    BoxData box;
+    std::string texturePath; ///< The box's texture, edits don't share a texture table
+    Light light;
+};
+
 class LevelReaderWriter
 {
 public:
     static bool saveAsText(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
+    static bool saveAsText(const std::string& filePath, const LevelData& level);
     static bool loadFromText(const std::string& filePath, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
+    static bool loadFromText(const std::string& filePath, LevelData& level);
+
+    // Copies the level objects into level. Player may be null.
+    static void makeLevelData(const Player* player, const std::vector<Box>& boxes, const std::vector<Light>& lights, LevelData& level);
+    // Creates the objects of level in world
+    static void buildLevel(const LevelData& level, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
+
+    static void makeBoxData(const Box& box, BoxData& data);
+    static void makePlayerData(const Player& player, PlayerData& data);
+
+    // Edit journals: a header naming the level the edits apply to, then one edit per line
+    static bool startJournal(const std::string& filePath, const std::string& basePath, size_t baseSize);
+    static bool appendToJournal(const std::string& filePath, const std::vector<LevelEdit>& edits);
+    static bool loadJournal(const std::string& filePath, std::string& basePath, size_t& baseSize, std::vector<LevelEdit>& edits);
+    static bool applyEdit(const LevelEdit& edit, LevelData& level);
 private:
-    static bool saveAsTextV0(const std::string& filePath, const Player& player, const std::vector<Box>& boxes, const std::vector<Light>& lights);
-    static bool loadAsTextV0(std::ifstream& file, b2World* world, Player& player, std::vector<Box>& boxes, std::vector<Light>& lights);
-};
\ No newline at end of file
+    static bool saveAsTextV0(const std::string& filePath, const LevelData& level);
+    static bool saveAsTextV1(const std::string& filePath, const LevelData& level);
+    static bool loadAsTextV0(TextTokenizer& tokenizer, LevelData& level);
+    static bool loadAsTextV1(TextTokenizer& tokenizer, LevelData& level);
+};
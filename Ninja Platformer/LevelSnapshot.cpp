@@ -0,0 +1,144 @@
+#include "LevelSnapshot.h"
+
+void LevelSnapshot::capture(b2World* world, const CharacterController& characters, const Bengine::SlotMap<Box>& boxes)
+{
+    clear();
+
+    m_bodies.reserve(world->GetBodyCount());
+    m_fixtures.reserve(world->GetBodyCount());
+
+    for (b2Body* b = world->GetBodyList(); b; b = b->GetNext()) {
+        BodyState s;
+        s.body = b;
+        s.position = b->GetPosition();
+        s.angle = b->GetAngle();
+        s.linearVelocity = b->GetLinearVelocity();
+        s.angularVelocity = b->GetAngularVelocity();
+        s.linearDamping = b->GetLinearDamping();
+        s.angularDamping = b->GetAngularDamping();
+        s.gravityScale = b->GetGravityScale();
+        s.type = b->GetType();
+        s.isAwake = b->IsAwake();
+        s.isActive = b->IsActive();
+        s.isBullet = b->IsBullet();
+        s.isFixedRotation = b->IsFixedRotation();
+        s.isSleepingAllowed = b->IsSleepingAllowed();
+        m_bodies.push_back(s);
+
+        for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext()) {
+            FixtureState fs;
+            fs.fixture = f;
+            fs.filter = f->GetFilterData();
+            fs.density = f->GetDensity();
+            fs.friction = f->GetFriction();
+            fs.restitution = f->GetRestitution();
+            fs.isSensor = f->IsSensor();
+            m_fixtures.push_back(fs);
+        }
+    }
+
+    m_gravity = world->GetGravity();
+    m_characters = characters;
+    m_boxes = boxes;
+}
+
+bool LevelSnapshot::restore(b2World* world, CharacterController& characters, Bengine::SlotMap<Box>& boxes) const
+{
+    if (!matches(world)) return false;
+
+    world->SetGravity(m_gravity);
+
+    size_t fixtureIndex = 0;
+    for (auto& s : m_bodies) {
+        b2Body* b = s.body;
+
+        { // Fixture properties
+            bool resetMass = false;
+            for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext()) {
+                const FixtureState& fs = m_fixtures[fixtureIndex++];
+                if (f->GetDensity() != fs.density) {
+                    f->SetDensity(fs.density);
+                    resetMass = true;
+                }
+                f->SetFriction(fs.friction);
+                f->SetRestitution(fs.restitution);
+                if (f->IsSensor() != fs.isSensor) f->SetSensor(fs.isSensor);
+
+                const b2Filter& filter = f->GetFilterData();
+                if (filter.categoryBits != fs.filter.categoryBits || filter.maskBits != fs.filter.maskBits ||
+                    filter.groupIndex != fs.filter.groupIndex) {
+                    f->SetFilterData(fs.filter);
+                }
+            }
+            if (resetMass) b->ResetMassData();
+        }
+
+        // Body properties. Type and rotation changes reset the mass, so they go before the velocities.
+        if (b->GetType() != s.type) b->SetType(s.type);
+        if (b->IsFixedRotation() != s.isFixedRotation) b->SetFixedRotation(s.isFixedRotation);
+        b->SetLinearDamping(s.linearDamping);
+        b->SetAngularDamping(s.angularDamping);
+        b->SetGravityScale(s.gravityScale);
+        b->SetBullet(s.isBullet);
+        b->SetSleepingAllowed(s.isSleepingAllowed);
+
+        // Bodies that haven't moved keep their broad-phase proxies and contacts.
+        // Static level geometry never moves, so a restart only touches what the player disturbed.
+        if (b->GetPosition() == s.position && b->GetAngle() == s.angle &&
+            b->GetLinearVelocity() == s.linearVelocity && b->GetAngularVelocity() == s.angularVelocity &&
+            b->IsAwake() == s.isAwake && b->IsActive() == s.isActive) {
+            continue;
+        }
+
+        // Deactivating drops the body's contacts, so it doesn't warm start from impulses
+        // it picked up after the snapshot. Moving an inactive body is also cheaper.
+        b->SetActive(false);
+        b->SetTransform(s.position, s.angle);
+        m_restoredBodies.push_back(&s);
+    }
+
+    // Reactivate in a second pass. Destroying a proxy scans the broad-phase move buffer,
+    // which every reactivated body adds to, so interleaving the two is quadratic.
+    // Going backwards hands the freed proxy ids back in the order they were taken, which keeps
+    // contact order, and so the simulation after a restart, the same as after the capture.
+    for (auto it = m_restoredBodies.rbegin(); it != m_restoredBodies.rend(); ++it) {
+        const BodyState* s = *it;
+        b2Body* b = s->body;
+        b->SetActive(s->isActive);
+        b->SetLinearVelocity(s->linearVelocity);
+        b->SetAngularVelocity(s->angularVelocity);
+        b->SetAwake(s->isAwake);
+    }
+    m_restoredBodies.clear();
+
+    characters = m_characters;
+    boxes = m_boxes;
+
+    return true;
+}
+
+void LevelSnapshot::clear()
+{
+    m_bodies.clear();
+    m_fixtures.clear();
+    m_characters.clear();
+    m_boxes.clear();
+}
+
+bool LevelSnapshot::matches(b2World* world) const
+{
+    if ((size_t)world->GetBodyCount() != m_bodies.size()) return false;
+
+    // New bodies go to the front of the list, so any change to the body set shows up here
+    size_t bodyIndex = 0;
+    size_t fixtureIndex = 0;
+    for (b2Body* b = world->GetBodyList(); b; b = b->GetNext()) {
+        if (b != m_bodies[bodyIndex++].body) return false;
+
+        for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext()) {
+            if (fixtureIndex == m_fixtures.size() || f != m_fixtures[fixtureIndex++].fixture) return false;
+        }
+    }
+
+    return fixtureIndex == m_fixtures.size();
+}
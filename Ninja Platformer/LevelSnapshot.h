@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <Bengine/SlotMap.h>
+#include <vector>
+
+#include "CharacterController.h"
+#include "Box.h"
+
+// The full simulation state of a level, so it can be restarted without reloading it.
+// Bodies aren't copied, the snapshot remembers their state and puts it back in place.
+class LevelSnapshot
+{
+public:
+    void capture(b2World* world, const CharacterController& characters, const Bengine::SlotMap<Box>& boxes);
+
+    // Puts the world, characters and boxes back the way they were when captured.
+    // Returns false without changing anything if bodies or fixtures were created or destroyed since.
+    bool restore(b2World* world, CharacterController& characters, Bengine::SlotMap<Box>& boxes) const;
+
+    void clear();
+
+    bool isEmpty() const { return m_bodies.empty(); }
+
+private:
+    struct FixtureState {
+        b2Fixture* fixture;
+        b2Filter filter;
+        float density;
+        float friction;
+        float restitution;
+        bool isSensor;
+    };
+
+    struct BodyState {
+        b2Body* body;
+        b2Vec2 position;
+        float angle;
+        b2Vec2 linearVelocity;
+        float angularVelocity;
+        float linearDamping;
+        float angularDamping;
+        float gravityScale;
+        b2BodyType type;
+        bool isAwake;
+        bool isActive;
+        bool isBullet;
+        bool isFixedRotation;
+        bool isSleepingAllowed;
+    };
+
+    bool matches(b2World* world) const;
+
+    std::vector<BodyState> m_bodies; ///< In world body list order
+    std::vector<FixtureState> m_fixtures; ///< In body then fixture list order
+    b2Vec2 m_gravity;
+    mutable std::vector<const BodyState*> m_restoredBodies; ///< Scratch space for restore()
+
+    // The characters and boxes only hold pointers into the world, so copies of them restore their bookkeeping.
+    // Copying the whole slot map keeps box handles from before the restore valid.
+    CharacterController m_characters;
+    Bengine::SlotMap<Box> m_boxes;
+};
@@ -0,0 +1,338 @@
+#include "LevelSoakTest.h"
+
+#include <Bengine/FrameStats.h>
+#include <Bengine/IOManager.h>
+#include <Bengine/ThreadPool.h>
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+
+#include "LevelReaderWriter.h"
+#include "LevelCooker.h"
+#include "BodyActivator.h"
+#include "CharacterController.h"
+#include "GameplaySettings.h"
+
+// Box2D moves a body at most b2_maxTranslation per step (288 m/s at 144 steps per second),
+// so anything getting close to that is out of control
+const float RUNAWAY_SPEED = 200.0f;
+// How far outside the level's starting bounds a body can get before it counts as lost
+const float OUT_OF_BOUNDS_MARGIN = 500.0f;
+
+static bool isFinite(const b2Vec2& v)
+{
+    return std::isfinite(v.x) && std::isfinite(v.y);
+}
+
+static void writeJsonString(FILE* file, const std::string& s)
+{
+    fputc('"', file);
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        }
+        else if ((unsigned char)c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned int)c);
+        }
+        else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+bool LevelSoakTest::parseArgs(int argc, char** argv, SoakTestSettings& settings)
+{
+    for (int i = 0; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (strcmp(arg, "--seconds") == 0 && hasValue) {
+            settings.seconds = (float)atof(argv[++i]);
+        }
+        else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            settings.numThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--levels") == 0 && hasValue) {
+            settings.levelsDirectory = argv[++i];
+        }
+        else if (strcmp(arg, "--out") == 0 && hasValue) {
+            settings.outputPath = argv[++i];
+        }
+        else if (strcmp(arg, "--input") == 0 && hasValue) {
+            const char* input = argv[++i];
+            if (strcmp(input, "idle") == 0) {
+                settings.input = SoakTestInput::IDLE;
+            }
+            else if (strcmp(input, "run") == 0) {
+                settings.input = SoakTestInput::RUN_AND_JUMP;
+            }
+            else {
+                printf("Unknown soak test input '%s', expected idle or run\n", input);
+                return false;
+            }
+        }
+        else {
+            printf("Unknown soak test argument '%s'\n", arg);
+            puts("Usage: --soak [--seconds N] [--input idle|run] [--threads N] [--levels DIR] [--out FILE|-]");
+            return false;
+        }
+    }
+
+    if (settings.seconds <= 0.0f || settings.numThreads < 0) {
+        puts("Soak test needs a positive number of seconds and threads");
+        return false;
+    }
+    return true;
+}
+
+bool LevelSoakTest::run(const SoakTestSettings& settings)
+{
+    std::vector<Bengine::DirEntry> entries;
+    if (!Bengine::IOManager::getDirectoryEntries(settings.levelsDirectory.c_str(), entries)) {
+        printf("Levels directory %s was not found!\n", settings.levelsDirectory.c_str());
+        return false;
+    }
+
+    std::vector<std::string> levelPaths;
+    for (auto& e : entries) {
+        if (!e.isDirectory) levelPaths.push_back(e.path);
+    }
+    // Same order every run, so results can be diffed
+    std::sort(levelPaths.begin(), levelPaths.end());
+
+    // Each level gets its own world, so levels can run side by side
+    std::vector<SoakTestResult> results(levelPaths.size());
+    Bengine::ThreadPool threadPool;
+    threadPool.init(settings.numThreads);
+    for (size_t i = 0; i < levelPaths.size(); i++) {
+        threadPool.addTask([&, i]() {
+            runLevel(levelPaths[i], settings, results[i]);
+        });
+    }
+    threadPool.waitForTasks();
+    threadPool.dispose();
+
+    if (!writeJson(settings.outputPath, settings, results)) {
+        perror(settings.outputPath.c_str());
+        return false;
+    }
+
+    if (settings.outputPath != "-") {
+        size_t numUnloaded = 0, numExploded = 0;
+        for (auto& r : results) {
+            if (!r.loaded) numUnloaded++;
+            if (r.exploded) numExploded++;
+        }
+        std::cout << "Soak tested " << results.size() << " levels: " << numExploded << " exploded, " << numUnloaded
+                  << " failed to load. Results are in " << settings.outputPath << "\n";
+    }
+    return true;
+}
+
+void LevelSoakTest::runLevel(const std::string& levelPath, const SoakTestSettings& settings, SoakTestResult& result)
+{
+    result = SoakTestResult();
+    result.levelPath = levelPath;
+
+    LevelData level;
+    if (!LevelReaderWriter::loadFromText(levelPath, level)) return;
+    result.loaded = true;
+
+    // Built like GameplayScreen does, minus the textures
+    b2World world(b2Vec2(0.0f, settings.gravity));
+    Bengine::ContactEventQueue contactEvents;
+    world.SetContactListener(&contactEvents);
+    Player player;
+    CharacterController characters;
+    std::vector<Box> boxes;
+    boxes.reserve(level.boxes.size());
+    for (auto& b : level.boxes) {
+        boxes.emplace_back();
+        boxes.back().init(&world, b.position, b.dimensions, Bengine::GLTexture(), b.color, b.isDynamic, b.angle, b.fixedRotation, b.uvRect);
+    }
+    if (level.hasPlayer) {
+        const PlayerData& p = level.player;
+        player.initBody(&world, p.position, p.drawDims, p.collisionDims, p.color);
+        player.setCharacter(characters.add(player.getCapsule()));
+        characters.subscribeContacts(contactEvents);
+    }
+    result.numMergedBoxes = LevelCooker::mergeStaticBoxes(&world, boxes);
+
+    BodyActivator bodyActivator;
+    bodyActivator.init(ACTIVATION_RADIUS, ACTIVATION_MARGIN);
+    for (auto& box : boxes) {
+        if (box.getIsDynamic()) bodyActivator.addBody(box.getBody());
+    }
+
+    // Stepped like the game, which runs one fixed step per frame at its target rate
+    Bengine::PhysicsQualityController physicsQuality;
+    physicsQuality.init(PHYSICS_BUDGET, MIN_PHYSICS_QUALITY, MAX_PHYSICS_QUALITY, Bengine::PhysicsQuality());
+
+    // Anything that gets far outside where the level started has been flung off it
+    b2AABB bounds;
+    bounds.lowerBound.Set(FLT_MAX, FLT_MAX);
+    bounds.upperBound.Set(-FLT_MAX, -FLT_MAX);
+    for (b2Body* b = world.GetBodyList(); b; b = b->GetNext()) {
+        result.numBodies++;
+        if (b->GetType() == b2_dynamicBody) result.numDynamicBodies++;
+        bounds.lowerBound = b2Min(bounds.lowerBound, b->GetPosition());
+        bounds.upperBound = b2Max(bounds.upperBound, b->GetPosition());
+    }
+    bounds.lowerBound -= b2Vec2(OUT_OF_BOUNDS_MARGIN, OUT_OF_BOUNDS_MARGIN);
+    bounds.upperBound += b2Vec2(OUT_OF_BOUNDS_MARGIN, OUT_OF_BOUNDS_MARGIN);
+
+    const size_t numSteps = (size_t)std::ceil(settings.seconds / settings.timeStep);
+    std::vector<double> stepTimes;
+    stepTimes.reserve(numSteps);
+    double sleepingRatioSum = 0.0;
+    std::unordered_set<b2Body*> lostBodies;
+
+    for (size_t step = 0; step < numSteps && !result.exploded; step++) {
+        float time = step * settings.timeStep;
+
+        if (level.hasPlayer && settings.input == SoakTestInput::RUN_AND_JUMP) {
+            // Run back and forth every two seconds, jumping every 0.75 seconds
+            const size_t JUMP_STEPS = std::max((size_t)(0.75f / settings.timeStep), (size_t)1);
+            int moveInput = ((int)(time / 2.0f) % 2 == 0) ? 1 : -1;
+            bool jump = (step % JUMP_STEPS == 0);
+            characters.setInput(player.getCharacter(), moveInput, jump);
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        if (level.hasPlayer) {
+            bodyActivator.update(player.getPosition());
+            characters.fixedUpdate(settings.timeStep);
+        }
+        physicsQuality.step(&world, settings.timeStep);
+        physicsQuality.endFrame();
+        contactEvents.dispatch();
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        stepTimes.push_back(std::chrono::duration<double, std::milli>(endTime - startTime).count());
+
+        // Look for anything that blew up
+        size_t numActive = 0;
+        size_t numSleeping = 0;
+        for (b2Body* b = world.GetBodyList(); b; b = b->GetNext()) {
+            if (b->GetType() != b2_dynamicBody || !b->IsActive()) continue;
+            if (lostBodies.count(b)) continue;
+            numActive++;
+            if (!b->IsAwake()) numSleeping++;
+
+            const b2Vec2& position = b->GetPosition();
+            const b2Vec2& velocity = b->GetLinearVelocity();
+            float speed = velocity.Length();
+            result.maxSpeed = std::max(result.maxSpeed, speed);
+
+            if (!isFinite(position) || !isFinite(velocity) || !std::isfinite(b->GetAngle()) || !std::isfinite(b->GetAngularVelocity())) {
+                result.exploded = true;
+                result.explosion = "nan";
+            }
+            else if (!bounds.Contains({ position, position })) {
+                // Falling off the edge isn't an explosion, but nothing comes back from out there
+                lostBodies.insert(b);
+                result.numLostBodies++;
+                if (level.hasPlayer && b == player.getCapsule().getBody()) {
+                    result.playerLost = true;
+                    result.playerLostTime = time + settings.timeStep;
+                }
+            }
+            else if (speed > RUNAWAY_SPEED) {
+                result.exploded = true;
+                result.explosion = "runaway velocity";
+            }
+
+            if (result.exploded) {
+                result.explosionTime = time + settings.timeStep;
+                break;
+            }
+        }
+
+        if (numActive > 0) {
+            float sleepingRatio = (float)numSleeping / numActive;
+            sleepingRatioSum += sleepingRatio;
+            result.finalSleepingRatio = sleepingRatio;
+        }
+
+        // The input has nothing left to drive
+        if (result.playerLost) break;
+    }
+
+    result.numSteps = stepTimes.size();
+    result.physics = physicsQuality.getStats();
+    if (!stepTimes.empty()) {
+        double total = 0.0;
+        for (double t : stepTimes) total += t;
+        result.stepMean = total / stepTimes.size();
+        result.meanSleepingRatio = (float)(sleepingRatioSum / stepTimes.size());
+
+        std::sort(stepTimes.begin(), stepTimes.end());
+        result.stepP50 = Bengine::getPercentile(stepTimes, 0.5);
+        result.stepP90 = Bengine::getPercentile(stepTimes, 0.9);
+        result.stepP99 = Bengine::getPercentile(stepTimes, 0.99);
+        result.stepMax = stepTimes.back();
+    }
+}
+
+bool LevelSoakTest::writeJson(const std::string& filePath, const SoakTestSettings& settings, const std::vector<SoakTestResult>& results)
+{
+    FILE* file = (filePath == "-") ? stdout : fopen(filePath.c_str(), "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"seconds\": %g,\n", settings.seconds);
+    fprintf(file, "  \"timeStep\": %g,\n", settings.timeStep);
+    fprintf(file, "  \"input\": \"%s\",\n", settings.input == SoakTestInput::IDLE ? "idle" : "run");
+    fprintf(file, "  \"levels\": [");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const SoakTestResult& r = results[i];
+        fprintf(file, i == 0 ? "\n" : ",\n");
+        fprintf(file, "    {\n      \"path\": ");
+        writeJsonString(file, r.levelPath);
+        fprintf(file, ",\n      \"loaded\": %s", r.loaded ? "true" : "false");
+        if (r.loaded) {
+            fprintf(file, ",\n      \"bodies\": %zu", r.numBodies);
+            fprintf(file, ",\n      \"dynamicBodies\": %zu", r.numDynamicBodies);
+            fprintf(file, ",\n      \"mergedBoxes\": %zu", r.numMergedBoxes);
+            fprintf(file, ",\n      \"steps\": %zu", r.numSteps);
+            fprintf(file, ",\n      \"stepMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+                    r.stepMean, r.stepP50, r.stepP90, r.stepP99, r.stepMax);
+            const Bengine::PhysicsStats& p = r.physics;
+            fprintf(file, ",\n      \"physics\": { \"budgetMs\": %.4f, \"overruns\": %u, \"qualityChanges\": %u, "
+                    "\"velocityIterations\": %d, \"positionIterations\": %d, \"subSteps\": %d }",
+                    p.budget, p.numOverruns, p.numQualityChanges,
+                    p.quality.velocityIterations, p.quality.positionIterations, p.quality.subSteps);
+            fprintf(file, ",\n      \"meanSleepingRatio\": %.4f", r.meanSleepingRatio);
+            fprintf(file, ",\n      \"finalSleepingRatio\": %.4f", r.finalSleepingRatio);
+            fprintf(file, ",\n      \"lostBodies\": %zu", r.numLostBodies);
+            fprintf(file, ",\n      \"playerLost\": %s", r.playerLost ? "true" : "false");
+            if (r.playerLost) fprintf(file, ",\n      \"playerLostTime\": %.4f", r.playerLostTime);
+            // An infinite speed is already reported as an explosion
+            fprintf(file, ",\n      \"maxSpeed\": %.4f", std::isfinite(r.maxSpeed) ? r.maxSpeed : 0.0f);
+            fprintf(file, ",\n      \"exploded\": %s", r.exploded ? "true" : "false");
+            if (r.exploded) {
+                fprintf(file, ",\n      \"explosion\": ");
+                writeJsonString(file, r.explosion);
+                fprintf(file, ",\n      \"explosionTime\": %.4f", r.explosionTime);
+            }
+        }
+        fprintf(file, "\n    }");
+    }
+
+    fprintf(file, "\n  ]\n}\n");
+
+    bool success = !ferror(file);
+    if (file != stdout) success = (fclose(file) == 0) && success;
+    return success;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Bengine/PhysicsQualityController.h>
+#include <string>
+#include <vector>
+
+enum class SoakTestInput { IDLE, RUN_AND_JUMP };
+
+struct SoakTestSettings {
+    std::string levelsDirectory = "Levels";
+    std::string outputPath = "SoakTest.json"; ///< "-" writes to stdout
+    float seconds = 60.0f;
+    float timeStep = 1.0f / 144.0f; ///< Same as the game's fixed step
+    float gravity = -34.0f; ///< Same as GameplayScreen
+    SoakTestInput input = SoakTestInput::IDLE;
+    int numThreads = 0; ///< 0 means one per hardware thread
+};
+
+struct SoakTestResult {
+    std::string levelPath;
+    bool loaded = false;
+    size_t numBodies = 0;
+    size_t numDynamicBodies = 0;
+    size_t numMergedBoxes = 0;
+    size_t numSteps = 0;
+    // Step times in milliseconds
+    double stepMean = 0.0;
+    double stepP50 = 0.0;
+    double stepP90 = 0.0;
+    double stepP99 = 0.0;
+    double stepMax = 0.0;
+    Bengine::PhysicsStats physics; ///< The quality the steps ended at, and how often it changed
+    // Fraction of active dynamic bodies asleep, averaged over the run and at the end
+    float meanSleepingRatio = 0.0f;
+    float finalSleepingRatio = 0.0f;
+    float maxSpeed = 0.0f;
+    // Bodies that fell out of the level aren't checked any more. The run stops if the player falls out.
+    size_t numLostBodies = 0;
+    bool playerLost = false;
+    float playerLostTime = 0.0f;
+    // The first explosion, if any. The level stops simulating there.
+    bool exploded = false;
+    std::string explosion = "";
+    float explosionTime = 0.0f;
+};
+
+// Runs every level in a directory without a window, one world per thread, and reports
+// how stable and how expensive each one is as JSON.
+class LevelSoakTest
+{
+public:
+    // Reads the arguments after --soak. Returns false on anything it doesn't understand.
+    static bool parseArgs(int argc, char** argv, SoakTestSettings& settings);
+
+    static bool run(const SoakTestSettings& settings);
+
+    static void runLevel(const std::string& levelPath, const SoakTestSettings& settings, SoakTestResult& result);
+
+    static bool writeJson(const std::string& filePath, const SoakTestSettings& settings, const std::vector<SoakTestResult>& results);
+};
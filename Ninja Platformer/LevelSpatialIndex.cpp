@@ -0,0 +1,241 @@
+#include "LevelSpatialIndex.h"
+
+#include <algorithm>
+
+// Bodies are tagged with index + 1, so untagged bodies like the player's read as 0
+static int getBoxIndex(const b2Body* body)
+{
+    return (int)(size_t)body->GetUserData() - 1;
+}
+
+static b2AABB makeAABB(const glm::vec2& lowerBound, const glm::vec2& upperBound)
+{
+    b2AABB aabb;
+    aabb.lowerBound.Set(lowerBound.x, lowerBound.y);
+    aabb.upperBound.Set(upperBound.x, upperBound.y);
+    return aabb;
+}
+
+// Sorts query results and drops duplicates
+static void finishResult(std::vector<int>& result)
+{
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+// Broad-phase callback that keeps the boxes whose fixture contains a point, or overlaps a shape
+class BoxQuery : public b2QueryCallback
+{
+public:
+    BoxQuery(std::vector<int>& result) : m_result(result)
+    {
+        // Empty
+    }
+
+    virtual bool ReportFixture(b2Fixture* fixture) override {
+        int index = getBoxIndex(fixture->GetBody());
+        if (index < 0) return true;
+
+        bool hit;
+        if (shape) {
+            hit = b2TestOverlap(shape, 0, fixture->GetShape(), 0, b2Transform(b2Vec2_zero, b2Rot(0.0f)), fixture->GetBody()->GetTransform());
+        }
+        else {
+            hit = fixture->TestPoint(point);
+        }
+        if (hit) m_result.push_back(index);
+        return true;
+    }
+
+    const b2Shape* shape = nullptr; ///< Null to test point instead
+    b2Vec2 point = b2Vec2_zero;
+
+private:
+    std::vector<int>& m_result;
+};
+
+// Light tree callback that keeps the lights whose select circle overlaps a rectangle or circle
+class LightQuery
+{
+public:
+    LightQuery(const std::vector<int>& proxyLights, const std::vector<glm::vec2>& positions, float selectRadius, std::vector<int>& result) :
+        m_proxyLights(proxyLights), m_positions(positions), m_selectRadius(selectRadius), m_result(result)
+    {
+        // Empty
+    }
+
+    bool QueryCallback(int32 proxyId) {
+        int index = m_proxyLights[proxyId];
+        const glm::vec2& position = m_positions[index];
+
+        // Closest point of the rectangle or circle to the light
+        glm::vec2 closest;
+        if (isCircle) {
+            glm::vec2 d = position - center;
+            float length = glm::length(d);
+            closest = (length > radius) ? center + d * (radius / length) : position;
+        }
+        else {
+            closest = glm::clamp(position, lowerBound, upperBound);
+        }
+
+        if (glm::length(position - closest) <= m_selectRadius) m_result.push_back(index);
+        return true;
+    }
+
+    bool isCircle = false;
+    glm::vec2 center;
+    float radius = 0.0f;
+    glm::vec2 lowerBound;
+    glm::vec2 upperBound;
+
+private:
+    const std::vector<int>& m_proxyLights;
+    const std::vector<glm::vec2>& m_positions;
+    float m_selectRadius;
+    std::vector<int>& m_result;
+};
+
+void LevelSpatialIndex::init(b2World* world, float lightSelectRadius)
+{
+    clear();
+    m_world = world;
+    m_lightSelectRadius = lightSelectRadius;
+}
+
+void LevelSpatialIndex::clear()
+{
+    for (int32 proxy : m_lightProxies) {
+        m_lightTree.DestroyProxy(proxy);
+    }
+    m_lightProxies.clear();
+    m_lightPositions.clear();
+    m_proxyLights.clear();
+}
+
+void LevelSpatialIndex::setBoxIndices(const std::vector<Box>& boxes, size_t first /*= 0*/)
+{
+    for (size_t i = first; i < boxes.size(); i++) {
+        setBoxIndex(boxes[i], i);
+    }
+}
+
+void LevelSpatialIndex::setBoxIndex(const Box& box, size_t index)
+{
+    if (box.getBody()) box.getBody()->SetUserData((void*)(index + 1));
+}
+
+void LevelSpatialIndex::setLights(const std::vector<Light>& lights)
+{
+    clear();
+    for (auto& l : lights) {
+        addLight(l);
+    }
+}
+
+void LevelSpatialIndex::addLight(const Light& light)
+{
+    int32 proxy = m_lightTree.CreateProxy(getLightAABB(light.position), nullptr);
+    if ((size_t)proxy >= m_proxyLights.size()) m_proxyLights.resize(proxy + 1, -1);
+    m_proxyLights[proxy] = (int)m_lightProxies.size();
+
+    m_lightProxies.push_back(proxy);
+    m_lightPositions.push_back(light.position);
+}
+
+void LevelSpatialIndex::moveLight(int index, const Light& light)
+{
+    glm::vec2 displacement = light.position - m_lightPositions[index];
+    m_lightTree.MoveProxy(m_lightProxies[index], getLightAABB(light.position), b2Vec2(displacement.x, displacement.y));
+    m_lightPositions[index] = light.position;
+}
+
+void LevelSpatialIndex::removeLight(int index)
+{
+    int32 proxy = m_lightProxies[index];
+    m_lightTree.DestroyProxy(proxy);
+    m_proxyLights[proxy] = -1;
+
+    m_lightProxies[index] = m_lightProxies.back();
+    m_lightPositions[index] = m_lightPositions.back();
+    m_lightProxies.pop_back();
+    m_lightPositions.pop_back();
+
+    if ((size_t)index < m_lightProxies.size()) m_proxyLights[m_lightProxies[index]] = index;
+}
+
+int LevelSpatialIndex::pickBox(const glm::vec2& point) const
+{
+    std::vector<int> result;
+    BoxQuery query(result);
+    query.point.Set(point.x, point.y);
+    m_world->QueryAABB(&query, makeAABB(point, point));
+
+    if (result.empty()) return -1;
+    return *std::min_element(result.begin(), result.end());
+}
+
+void LevelSpatialIndex::queryBoxes(const glm::vec2& lowerBound, const glm::vec2& upperBound, std::vector<int>& result) const
+{
+    result.clear();
+
+    b2PolygonShape rect;
+    glm::vec2 halfDims = (upperBound - lowerBound) / 2.0f;
+    glm::vec2 center = lowerBound + halfDims;
+    rect.SetAsBox(halfDims.x, halfDims.y, b2Vec2(center.x, center.y), 0.0f);
+
+    BoxQuery query(result);
+    query.shape = &rect;
+    m_world->QueryAABB(&query, makeAABB(lowerBound, upperBound));
+    finishResult(result);
+}
+
+void LevelSpatialIndex::queryBoxes(const glm::vec2& center, float radius, std::vector<int>& result) const
+{
+    result.clear();
+
+    b2CircleShape circle;
+    circle.m_p.Set(center.x, center.y);
+    circle.m_radius = radius;
+
+    BoxQuery query(result);
+    query.shape = &circle;
+    m_world->QueryAABB(&query, makeAABB(center - glm::vec2(radius), center + glm::vec2(radius)));
+    finishResult(result);
+}
+
+int LevelSpatialIndex::pickLight(const glm::vec2& point) const
+{
+    std::vector<int> result;
+    queryLights(point, 0.0f, result);
+    return result.empty() ? -1 : result.front();
+}
+
+void LevelSpatialIndex::queryLights(const glm::vec2& lowerBound, const glm::vec2& upperBound, std::vector<int>& result) const
+{
+    result.clear();
+
+    LightQuery query(m_proxyLights, m_lightPositions, m_lightSelectRadius, result);
+    query.lowerBound = lowerBound;
+    query.upperBound = upperBound;
+    m_lightTree.Query(&query, makeAABB(lowerBound - glm::vec2(m_lightSelectRadius), upperBound + glm::vec2(m_lightSelectRadius)));
+    finishResult(result);
+}
+
+void LevelSpatialIndex::queryLights(const glm::vec2& center, float radius, std::vector<int>& result) const
+{
+    result.clear();
+
+    LightQuery query(m_proxyLights, m_lightPositions, m_lightSelectRadius, result);
+    query.isCircle = true;
+    query.center = center;
+    query.radius = radius;
+    glm::vec2 reach(radius + m_lightSelectRadius);
+    m_lightTree.Query(&query, makeAABB(center - reach, center + reach));
+    finishResult(result);
+}
+
+b2AABB LevelSpatialIndex::getLightAABB(const glm::vec2& position) const
+{
+    return makeAABB(position - glm::vec2(m_lightSelectRadius), position + glm::vec2(m_lightSelectRadius));
+}
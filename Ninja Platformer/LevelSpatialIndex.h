@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Box2D/Box2D.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Box.h"
+#include "Light.h"
+
+// Finds level objects by position without looking at all of them.
+// Boxes are found through the world's broad-phase, with each body remembering its box's index.
+// Lights are circles of the select radius in a b2DynamicTree.
+// Queries return indices in ascending order, picks return the lowest index or -1.
+class LevelSpatialIndex
+{
+public:
+    void init(b2World* world, float lightSelectRadius);
+    void clear();
+
+    // Tags the bodies of boxes[first] onwards with their index
+    void setBoxIndices(const std::vector<Box>& boxes, size_t first = 0);
+    // Tags one box's body, for a box that was added or moved to index
+    void setBoxIndex(const Box& box, size_t index);
+
+    void setLights(const std::vector<Light>& lights);
+    void addLight(const Light& light);
+    void moveLight(int index, const Light& light);
+    // Moves the last light into index, the same way SlotMap::remove does
+    void removeLight(int index);
+
+    int pickBox(const glm::vec2& point) const;
+    void queryBoxes(const glm::vec2& lowerBound, const glm::vec2& upperBound, std::vector<int>& result) const;
+    void queryBoxes(const glm::vec2& center, float radius, std::vector<int>& result) const;
+
+    int pickLight(const glm::vec2& point) const;
+    void queryLights(const glm::vec2& lowerBound, const glm::vec2& upperBound, std::vector<int>& result) const;
+    void queryLights(const glm::vec2& center, float radius, std::vector<int>& result) const;
+
+private:
+    b2AABB getLightAABB(const glm::vec2& position) const;
+
+    b2World* m_world = nullptr;
+    float m_lightSelectRadius = 0.0f;
+
+    b2DynamicTree m_lightTree;
+    std::vector<int32> m_lightProxies; ///< Tree proxy of each light
+    std::vector<glm::vec2> m_lightPositions;
+    std::vector<int> m_proxyLights; ///< Light of each tree proxy
+};
@@ -0,0 +1,115 @@
+#include "PacingBenchmark.h"
+
+#include <Bengine/FrameStats.h>
+#include <Bengine/Timing.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+const float TARGET_RATES[] = { 60.0f, 144.0f, 240.0f };
+// Each frame works for a random part of the frame time, like update and draw would
+const float MIN_WORK = 0.1f;
+const float MAX_WORK = 0.7f;
+
+// Keeps the CPU busy, as a frame would
+static void work(double seconds)
+{
+    const Uint64 end = SDL_GetPerformanceCounter() + (Uint64)(seconds * SDL_GetPerformanceFrequency());
+    while (SDL_GetPerformanceCounter() < end) {
+        // Spin
+    }
+}
+
+bool PacingBenchmark::parseArgs(int argc, char** argv, float& secondsPerRate)
+{
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            secondsPerRate = (float)atof(argv[++i]);
+        }
+        else {
+            printf("Unknown pacing benchmark argument: %s\n", argv[i]);
+            return false;
+        }
+    }
+    return secondsPerRate > 0.0f;
+}
+
+bool PacingBenchmark::run(float secondsPerRate)
+{
+    // The game's timer resolution is set up by SDL_Init(), and that decides how long SDL_Delay() sleeps
+    if (SDL_Init(SDL_INIT_TIMER) != 0) {
+        printf("SDL_Init failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    std::vector<PacingBenchmarkResult> results;
+    for (float rate : TARGET_RATES) {
+        results.push_back(runRate(rate, secondsPerRate));
+    }
+
+    SDL_Quit();
+
+    print(results);
+    return true;
+}
+
+PacingBenchmarkResult PacingBenchmark::runRate(float targetFPS, float seconds)
+{
+    PacingBenchmarkResult result;
+    result.targetFPS = targetFPS;
+
+    const double frameTime = 1000.0 / targetFPS;
+    const int numFrames = (int)(seconds * targetFPS);
+
+    // Same work every run, so runs can be compared
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> workTime(MIN_WORK * frameTime * 0.001, MAX_WORK * frameTime * 0.001);
+
+    Bengine::FPSLimiter limiter;
+    limiter.setMaxFPS(targetFPS);
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(numFrames);
+    for (int i = 0; i < numFrames; i++) {
+        limiter.begin();
+        work(workTime(random));
+        limiter.end();
+        // The first frame has no previous one to measure from
+        if (i > 0) frameTimes.push_back(limiter.getStats().frameTime);
+    }
+    if (frameTimes.empty()) return result;
+
+    result.numFrames = (int)frameTimes.size();
+    result.numMissedDeadlines = limiter.getStats().numMissedDeadlines;
+
+    double sum = 0.0;
+    for (double time : frameTimes) sum += time;
+    result.mean = sum / frameTimes.size();
+
+    double variance = 0.0;
+    std::vector<double> errors;
+    for (double time : frameTimes) {
+        variance += (time - result.mean) * (time - result.mean);
+        errors.push_back(std::abs(time - frameTime));
+    }
+    result.jitter = std::sqrt(variance / frameTimes.size());
+    result.max = *std::max_element(frameTimes.begin(), frameTimes.end());
+
+    std::sort(errors.begin(), errors.end());
+    result.errorP50 = Bengine::getPercentile(errors, 0.5);
+    result.errorP99 = Bengine::getPercentile(errors, 0.99);
+
+    return result;
+}
+
+void PacingBenchmark::print(const std::vector<PacingBenchmarkResult>& results)
+{
+    printf("target FPS  frames  mean ms  jitter ms  error p50 ms  error p99 ms  max ms  missed\n");
+    for (auto& r : results) {
+        printf("%10.0f  %6d  %7.3f  %9.3f  %12.3f  %12.3f  %6.2f  %6d\n",
+               r.targetFPS, r.numFrames, r.mean, r.jitter, r.errorP50, r.errorP99, r.max, r.numMissedDeadlines);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+struct PacingBenchmarkResult {
+    float targetFPS = 0.0f;
+    int numFrames = 0;
+    // Frame times in milliseconds
+    double mean = 0.0;
+    double jitter = 0.0; ///< Standard deviation
+    double errorP50 = 0.0; ///< How far frames were from the target frame time
+    double errorP99 = 0.0;
+    double max = 0.0;
+    int numMissedDeadlines = 0;
+};
+
+// Paces frames of made up work with FPSLimiter at 60, 144 and 240 FPS, without a window,
+// and prints how steady the frame times were
+class PacingBenchmark
+{
+public:
+    // Reads the arguments after --pacing-benchmark. Returns false on anything it doesn't understand.
+    static bool parseArgs(int argc, char** argv, float& secondsPerRate);
+
+    static bool run(float secondsPerRate);
+
+    static PacingBenchmarkResult runRate(float targetFPS, float seconds);
+
+    static void print(const std::vector<PacingBenchmarkResult>& results);
+};
@@ -13,12 +13,18 @@ Player::~Player()
 void Player::init(b2World* world, const glm::vec2& position, const glm::vec2& drawDims, const glm::vec2& collisionDims, Bengine::ColorRGBA8 color)
 {
     Bengine::GLTexture texture = Bengine::ResourceManager::getTexture("Assets/blue_ninja.png");
+    m_texture.init(texture, glm::ivec2(10, 2));
+
+    initBody(world, position, drawDims, collisionDims, color);
+}
+
+void Player::initBody(b2World* world, const glm::vec2& position, const glm::vec2& drawDims, const glm::vec2& collisionDims, Bengine::ColorRGBA8 color)
+{
     m_color = color;
     m_drawDims = drawDims;
     m_collisionDims = collisionDims;
 
     m_capsule.init(world, position, collisionDims, 1.0f, 0.3f, true);
-    m_texture.init(texture, glm::ivec2(10, 2));
 }
 
 void Player::destroy(b2World* world)
@@ -26,157 +32,49 @@ void Player::destroy(b2World* world)
     m_capsule.destroy(world);
 }
 
-void Player::update(Bengine::InputManager& inputManager)
+PlayerInput Player::readInput(Bengine::InputManager& inputManager)
 {
-    const float MAX_SPEED = 20.0f;
-
-    b2Body* body = m_capsule.getBody();
-
+    PlayerInput input;
     if (inputManager.isKeyDown(SDLK_a) || inputManager.isKeyDown(SDLK_LEFT)) {
-        body->ApplyForceToCenter(b2Vec2(-325.0f, 0.0f), true);
-        m_direction = -1;
+        input.move = -1;
     }
     else if (inputManager.isKeyDown(SDLK_d) || inputManager.isKeyDown(SDLK_RIGHT)) {
-        body->ApplyForceToCenter(b2Vec2(325.0f, 0.0f), true);
-        m_direction = 1;
-    }
-    else {
-        // Apply damping
-        body->SetLinearVelocity(b2Vec2(body->GetLinearVelocity().x * 0.99f, body->GetLinearVelocity().y));
+        input.move = 1;
     }
 
-    // Limit the speed of the player
-    if (body->GetLinearVelocity().x < -MAX_SPEED) {
-        body->SetLinearVelocity(b2Vec2(-MAX_SPEED, body->GetLinearVelocity().y));
-    }
-    else if (body->GetLinearVelocity().x > MAX_SPEED) {
-        body->SetLinearVelocity(b2Vec2(MAX_SPEED, body->GetLinearVelocity().y));
-    }
+    input.jump = inputManager.isKeyPressed(SDLK_w) || inputManager.isKeyPressed(SDLK_UP);
+    input.punch = inputManager.isKeyPressed(SDLK_SPACE);
 
-    // Punch
-    if (inputManager.isKeyPressed(SDLK_SPACE)) {
-        m_isPunching = true;
-    }
-
-    // Loop through all the contact points
-    m_onGround = false;
-    for (b2ContactEdge* ce = body->GetContactList(); ce != nullptr; ce = ce->next) {
-        b2Contact* c = ce->contact;
-        if (c->IsTouching()) {
-            b2WorldManifold manifold;
-            c->GetWorldManifold(&manifold);
-
-            // Check if points are below
-            for (size_t i = 0; i < b2_maxManifoldPoints; i++) {
-                if (manifold.points[i].y < body->GetPosition().y - m_capsule.getDimensions().y / 2.0f + m_capsule.getDimensions().x / 2.0f + 0.01f) {
-                    // It's touching the player's feet
-                    m_onGround = true;
-                    break;
-                }
-            }
-
-            if (m_onGround) {
-                // We can jump
-                if (inputManager.isKeyPressed(SDLK_w) || inputManager.isKeyPressed(SDLK_UP)) {
-                    body->ApplyLinearImpulse(b2Vec2(0.0f, 60.0f), b2Vec2(0.0f, 0.0f), true);
-                }
-                break;
-            }
-        }
-    }
+    return input;
 }
 
 void Player::draw(Bengine::SpriteBatch& spriteBatch)
 {
-    b2Body* body = m_capsule.getBody();
+    drawSprite(spriteBatch, getPosition(), m_capsule.getBody()->GetAngle(), 0, 1);
+}
 
+void Player::draw(Bengine::SpriteBatch& spriteBatch, const CharacterStates& states, const CharacterAnimator& animator, float alpha)
+{
+    const int i = m_character;
+    glm::vec2 position = glm::mix(glm::vec2(states.previousX[i], states.previousY[i]), glm::vec2(states.x[i], states.y[i]), alpha);
+    float angle = glm::mix(states.previousAngle[i], states.angle[i], alpha);
+
+    drawSprite(spriteBatch, position, angle, animator.getTileIndex(i), animator.getDirection(i));
+}
+
+void Player::drawSprite(Bengine::SpriteBatch& spriteBatch, const glm::vec2& position, float angle, int tileIndex, int direction)
+{
     glm::vec4 destRect(
-        body->GetPosition().x - m_drawDims.x / 2.0f,
-        body->GetPosition().y - m_capsule.getDimensions().y / 2.0f,
+        position.x - m_drawDims.x / 2.0f,
+        position.y - m_capsule.getDimensions().y / 2.0f,
         m_drawDims
     );
 
-    int tileIndex;
-    int numTiles;
-
-    // Get velocity
-    b2Vec2 velocity = body->GetLinearVelocity();
-
-    float animationSpeed = 0.1f;
-    // Calculate animation
-    if (m_onGround) {
-        if (m_isPunching) {
-            // Punching on ground
-            numTiles = 4;
-            tileIndex = 1;
-            if (m_moveState != PlayerMoveState::PUNCHING) {
-                m_moveState = PlayerMoveState::PUNCHING;
-                m_animationTime = 0.0f;
-            }
-        }
-        else if (abs(velocity.x) > 1.0f && (velocity.x > 0 && m_direction > 0) || (velocity.x < 0 && m_direction < 0)) {
-            // Running
-            numTiles = 6;
-            tileIndex = 10;
-            animationSpeed = abs(velocity.x) * 0.005f;
-            if (m_moveState != PlayerMoveState::RUNNING) {
-                m_moveState = PlayerMoveState::RUNNING;
-                m_animationTime = 0.0f;
-            }
-        }
-        else {
-            // Standing
-            numTiles = 1;
-            tileIndex = 0;
-            m_moveState = PlayerMoveState::STANDING;
-        }
-    }
-    else {
-        // In the air
-        if (m_isPunching) {
-            // Kicking in the air
-            animationSpeed *= 0.25f;
-            numTiles = 1;
-            tileIndex = 18;
-            if (m_moveState != PlayerMoveState::PUNCHING) {
-                m_moveState = PlayerMoveState::PUNCHING;
-                m_animationTime = 0.0f;
-            }
-        }
-        else if (abs(velocity.x) > 19.5f) {
-            // Going fast in the air
-            numTiles = 1;
-            tileIndex = 10;
-            m_moveState = PlayerMoveState::IN_AIR;
-        }
-        else if (velocity.y <= 0) {
-            // Falling
-            numTiles = 1;
-            tileIndex = 17;
-            m_moveState = PlayerMoveState::IN_AIR;
-        }
-        else {
-            // Rising
-            numTiles = 1;
-            tileIndex = 16;
-            m_moveState = PlayerMoveState::IN_AIR;
-        }
-    }
-
-    // Increment animation time
-    m_animationTime += animationSpeed;
-
-    // Check for punch end
-    if (m_animationTime > numTiles) m_isPunching = false;
-
-    // Apply animation
-    tileIndex += (int)m_animationTime % numTiles;
-
     // Get UV coordinates
     glm::vec4 uvRect = m_texture.getUV(tileIndex);
 
     // Check direction
-    if (m_direction == -1) {
+    if (direction == -1) {
         uvRect.x += 1.0f / m_texture.dims.x;
         uvRect.z *= -1;
     }
@@ -188,7 +86,7 @@ void Player::draw(Bengine::SpriteBatch& spriteBatch)
         m_texture.texture.id,
         0.0f,
         m_color,
-        m_capsule.getBody()->GetAngle()
+        angle
     );
 }
 
@@ -197,3 +95,9 @@ void Player::drawDebug(Bengine::DebugRenderer& debugRenderer)
 {
     m_capsule.drawDebug(debugRenderer);
 }
+
+void Player::drawDebug(Bengine::DebugRenderer& debugRenderer, const CharacterStates& states)
+{
+    const int i = m_character;
+    m_capsule.drawDebug(debugRenderer, glm::vec2(states.x[i], states.y[i]), states.angle[i]);
+}
@@ -6,8 +6,18 @@
 #include <Bengine/InputManager.h>   
 #include <Bengine/DebugRenderer.h>
 
-enum class PlayerMoveState {STANDING, RUNNING, PUNCHING, IN_AIR};
+#include "CharacterController.h"
+#include "CharacterAnimator.h"
 
+// Input read from the keyboard, once per frame
+struct PlayerInput {
+    int move = 0; ///< -1, 0 or 1
+    bool jump = false;
+    bool punch = false;
+};
+
+// How the player looks. Its movement is run by a CharacterController and its animation
+// by a CharacterAnimator, under the character index set with setCharacter().
 class Player
 {
 public:
@@ -22,10 +32,29 @@ public:
         Bengine::ColorRGBA8 color
     );
 
+    // Makes the body without loading the sprite sheet, so levels can run without a GL context
+    void initBody(
+        b2World* world,
+        const glm::vec2& position,
+        const glm::vec2& drawDims,
+        const glm::vec2& collisionDims,
+        Bengine::ColorRGBA8 color
+    );
+
     void destroy(b2World* world);
-    void update(Bengine::InputManager& inputManager);
+
+    static PlayerInput readInput(Bengine::InputManager& inputManager);
+
+    void setCharacter(int index) { m_character = index; }
+    int getCharacter() const { return m_character; }
+
+    // Draws the player standing where the body is, for when nothing animates it
     void draw(Bengine::SpriteBatch& spriteBatch);
+    // Draws the player's character alpha of the way from its previous transform to its current one.
+    // Only reads states and animator, so the body can be stepping on another thread.
+    void draw(Bengine::SpriteBatch& spriteBatch, const CharacterStates& states, const CharacterAnimator& animator, float alpha);
     void drawDebug(Bengine::DebugRenderer& debugRenderer);
+    void drawDebug(Bengine::DebugRenderer& debugRenderer, const CharacterStates& states);
 
     const Capsule& getCapsule() const { return m_capsule; }
     const glm::vec2& getDrawDims() const { return m_drawDims; }
@@ -34,15 +63,12 @@ public:
     glm::vec2 getPosition() const { return glm::vec2(m_capsule.getBody()->GetPosition().x, m_capsule.getBody()->GetPosition().y); }
 
 private:
+    void drawSprite(Bengine::SpriteBatch& spriteBatch, const glm::vec2& position, float angle, int tileIndex, int direction);
+
     glm::vec2 m_drawDims;
     glm::vec2 m_collisionDims;
     Bengine::TileSheet m_texture;
     Bengine::ColorRGBA8 m_color;
     Capsule m_capsule;
-    PlayerMoveState m_moveState = PlayerMoveState::STANDING;
-    float m_animationTime = 0.0f;
-    bool m_onGround = false;
-    bool m_isPunching = false;
-    int m_direction = 1; // 1 or -1
+    int m_character = -1;
 };
-
@@ -1,7 +1,65 @@
 #include "App.h"
+#include "LevelSoakTest.h"
+#include "PacingBenchmark.h"
+#include <Bengine/Profiler.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char** argv) {
+    // Soak testing runs every level without opening a window
+    if (argc > 1 && strcmp(argv[1], "--soak") == 0) {
+        SoakTestSettings settings;
+        if (!LevelSoakTest::parseArgs(argc - 2, argv + 2, settings)) return 1;
+        return LevelSoakTest::run(settings) ? 0 : 1;
+    }
+
+    // Measures how close FPSLimiter keeps frames to their target time
+    if (argc > 1 && strcmp(argv[1], "--pacing-benchmark") == 0) {
+        float secondsPerRate = 10.0f;
+        if (!PacingBenchmark::parseArgs(argc - 2, argv + 2, secondsPerRate)) return 1;
+        return PacingBenchmark::run(secondsPerRate) ? 0 : 1;
+    }
+
     App app;
+
+    // A level file can be passed on the command line, physics can step on its own thread,
+    // frame times can be written to a file, and so can a trace of a range of frames
+    std::string tracePath = "trace.json";
+    int traceFirstFrame = -1;
+    int traceNumFrames = 120;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        int numValues = 0;
+        if (strcmp(arg, "--frame-stats") == 0 || strcmp(arg, "--trace") == 0) numValues = 1;
+        if (strcmp(arg, "--trace-frames") == 0) numValues = 2;
+        if (i + numValues >= argc) {
+            printf("Missing value for %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "--physics-thread") == 0) {
+            app.setPhysicsThreadEnabled(true);
+        }
+        else if (strcmp(arg, "--frame-stats") == 0) {
+            app.setFrameStatsPath(argv[++i]);
+        }
+        else if (strcmp(arg, "--trace") == 0) {
+            tracePath = argv[++i];
+        }
+        else if (strcmp(arg, "--trace-frames") == 0) {
+            traceFirstFrame = atoi(argv[++i]);
+            traceNumFrames = atoi(argv[++i]);
+        }
+        else {
+            app.setLevelPath(arg);
+        }
+    }
+
+    // F10 traces the next frames to the same file
+    app.setTracePath(tracePath, traceNumFrames);
+    if (traceFirstFrame >= 0) Bengine::Profiler::captureFrames(traceNumFrames, tracePath, traceFirstFrame);
+
     app.run();
 
     return 0;